@@ -0,0 +1,488 @@
+/*
+ * Project: Slow Motion Showdown host device server
+ * Description: Stands in for the classroom's Hue bridge and Wemo outlets on
+ *              a Linux box. Serves the Hue REST calls hue.h makes (light
+ *              state, groups) and the Belkin basicevent1 SOAP call wemo.h
+ *              makes, keeps their state, and can add latency, error replies
+ *              and dropped connections to reproduce a flaky network.
+ *
+ *              Each device listens on its own loopback address, the bridge
+ *              on 127.0.0.5 and the outlets on 127.0.0.30-35, matching the
+ *              last octets of the classroom addresses. network_bench is
+ *              built to talk to these.
+ *
+ * Usage: device_server [-latency ms] [-jitter ms] [-errors pct] [-drops pct]
+ *                      [-idle ms] [-v]
+ *   -latency  delay before each reply
+ *   -jitter   up to this much extra delay, picked at random per reply
+ *   -errors   percentage of requests answered with 500
+ *   -drops    percentage of requests whose connection is closed unanswered
+ *   -idle     close keep-alive connections idle this long, like the bridge
+ *   -v        log every request
+*/
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const char HUE_ADDRESS[] = "127.0.0.5";
+static const int HUE_PORT = 8080;
+static const char WEMO_ADDRESS_PREFIX[] = "127.0.0.";
+static const int WEMO_FIRST_OCTET = 30;
+static const int WEMO_OUTLETS = 6;
+static const int WEMO_PORT = 49153;
+
+struct Faults {
+  int latencyMs = 0;
+  int jitterMs = 0;
+  int errorPct = 0;
+  int dropPct = 0;
+  int idleMs = 0;
+};
+
+static Faults faults;
+static bool verbose = false;
+
+/* ------------------------------------------------------------------------ */
+/* Device state                                                             */
+/* ------------------------------------------------------------------------ */
+
+struct LightState {
+  bool on = false;
+  int bri = 254;
+  int hue = 8418;
+  int sat = 140;
+};
+
+struct Group {
+  std::string name;
+  std::vector<int> lights;
+  LightState action;
+};
+
+static std::mutex stateLock;
+static std::map<int, LightState> lights;
+static std::map<int, Group> groups;
+static bool outlets[WEMO_OUTLETS];
+
+//  The text after "key": in a JSON body, or NULL. Good enough for the
+//  flat objects hue.h sends.
+static const char *jsonValue(const std::string &body, const char *key) {
+  std::string needle = std::string("\"") + key + "\":";
+  size_t at = body.find(needle);
+  return at == std::string::npos ? NULL : body.c_str() + at + needle.size();
+}
+
+static std::string jsonString(const std::string &body, const char *key) {
+  const char *value = jsonValue(body, key);
+  if (!value || *value != '"') {
+    return "";
+  }
+  const char *end = strchr(value + 1, '"');
+  return end ? std::string(value + 1, end) : "";
+}
+
+static std::vector<int> jsonLights(const std::string &body) {
+  std::vector<int> list;
+  const char *value = jsonValue(body, "lights");
+  if (!value || *value != '[') {
+    return list;
+  }
+  for (const char *p = value + 1; *p && *p != ']'; p++) {
+    if (*p == '"') {
+      list.push_back(atoi(p + 1));
+      p = strchr(p + 1, '"');
+      if (!p) {
+        break;
+      }
+    }
+  }
+  return list;
+}
+
+//  Apply the fields of a state or action body
+static void applyState(LightState &state, const std::string &body) {
+  const char *value;
+  if ((value = jsonValue(body, "on"))) {
+    state.on = strncmp(value, "true", 4) == 0;
+  }
+  if ((value = jsonValue(body, "bri"))) {
+    state.bri = atoi(value);
+  }
+  if ((value = jsonValue(body, "hue"))) {
+    state.hue = atoi(value);
+  }
+  if ((value = jsonValue(body, "sat"))) {
+    state.sat = atoi(value);
+  }
+}
+
+static std::string stateJson(const LightState &state) {
+  char json[160];
+  snprintf(json, sizeof(json),
+           "{\"on\":%s,\"bri\":%d,\"hue\":%d,\"sat\":%d,\"effect\":\"none\","
+           "\"ct\":366,\"colormode\":\"hs\",\"reachable\":true}",
+           state.on ? "true" : "false", state.bri, state.hue, state.sat);
+  return json;
+}
+
+static std::string groupJson(const Group &group) {
+  std::string json = "{\"name\":\"" + group.name + "\",\"lights\":[";
+  for (size_t i = 0; i < group.lights.size(); i++) {
+    json += (i ? ",\"" : "\"") + std::to_string(group.lights[i]) + "\"";
+  }
+  json += "],\"type\":\"LightGroup\",\"action\":" + stateJson(group.action) + "}";
+  return json;
+}
+
+/* ------------------------------------------------------------------------ */
+/* Requests                                                                 */
+/* ------------------------------------------------------------------------ */
+
+struct Request {
+  std::string method;
+  std::string path;
+  std::string body;
+  std::string soapAction;
+  bool close = false;
+};
+
+struct Reply {
+  int status = 200;
+  std::string contentType = "application/json";
+  std::string body;
+};
+
+//  The Hue API below /api/<username>
+static Reply hueReply(const Request &request) {
+  Reply reply;
+  std::vector<std::string> parts;
+  size_t start = 1;
+  while (start <= request.path.size()) {
+    size_t slash = request.path.find('/', start);
+    if (slash == std::string::npos) {
+      slash = request.path.size();
+    }
+    parts.push_back(request.path.substr(start, slash - start));
+    start = slash + 1;
+  }
+
+  std::lock_guard<std::mutex> lock(stateLock);
+  if (parts.size() < 3 || parts[0] != "api") {
+    reply.status = 404;
+    reply.body = "[{\"error\":{\"type\":3,\"description\":\"resource not available\"}}]";
+    return reply;
+  }
+  const std::string &kind = parts[2];
+  int id = parts.size() > 3 ? atoi(parts[3].c_str()) : -1;
+
+  if (kind == "lights" && id > 0) {
+    LightState &light = lights[id];
+    if (request.method == "PUT" && parts.size() > 4 && parts[4] == "state") {
+      applyState(light, request.body);
+      reply.body = "[{\"success\":{\"/lights/" + parts[3] + "/state/on\":" +
+                   (light.on ? "true" : "false") + "}}]";
+    } else {
+      reply.body = "{\"state\":" + stateJson(light) + ",\"type\":\"Extended color light\","
+                   "\"name\":\"Hue color lamp " + parts[3] + "\"}";
+    }
+  } else if (kind == "groups" && id < 0) {
+    if (request.method == "POST") {
+      int newId = groups.empty() ? 1 : groups.rbegin()->first + 1;
+      groups[newId].name = jsonString(request.body, "name");
+      groups[newId].lights = jsonLights(request.body);
+      reply.body = "[{\"success\":{\"id\":\"" + std::to_string(newId) + "\"}}]";
+    } else {
+      reply.body = "{";
+      for (auto &entry : groups) {
+        if (reply.body.size() > 1) {
+          reply.body += ",";
+        }
+        reply.body += "\"" + std::to_string(entry.first) + "\":" + groupJson(entry.second);
+      }
+      reply.body += "}";
+    }
+  } else if (kind == "groups" && (id == 0 || groups.count(id))) {
+    if (request.method == "PUT" && parts.size() > 4 && parts[4] == "action") {
+      std::vector<int> members;
+      if (id == 0) {
+        for (auto &entry : lights) {
+          members.push_back(entry.first);
+        }
+      } else {
+        applyState(groups[id].action, request.body);
+        members = groups[id].lights;
+      }
+      for (int member : members) {
+        applyState(lights[member], request.body);
+      }
+      reply.body = "[{\"success\":{\"/groups/" + parts[3] + "/action/on\":true}}]";
+    } else if (request.method == "PUT") {
+      std::string name = jsonString(request.body, "name");
+      if (!name.empty()) {
+        groups[id].name = name;
+      }
+      if (jsonValue(request.body, "lights")) {
+        groups[id].lights = jsonLights(request.body);
+      }
+      reply.body = "[{\"success\":{\"/groups/" + parts[3] + "/lights\":\"updated\"}}]";
+    } else {
+      reply.body = groupJson(groups[id]);
+    }
+  } else {
+    //  Like the bridge: 200 OK, with the refusal in the body
+    std::string address = request.path.substr(request.path.find('/', 5));
+    reply.body = "[{\"error\":{\"type\":3,\"address\":\"" + address +
+                 "\",\"description\":\"resource, " + address + ", not available\"}}]";
+  }
+  return reply;
+}
+
+//  The Belkin basicevent1 service of one outlet
+static Reply wemoReply(int outlet, const Request &request) {
+  Reply reply;
+  reply.contentType = "text/xml; charset=\"utf-8\"";
+  if (request.method != "POST" || request.path != "/upnp/control/basicevent1" ||
+      request.soapAction.find("SetBinaryState") == std::string::npos) {
+    reply.status = 500;
+    return reply;
+  }
+  size_t at = request.body.find("<BinaryState>");
+  if (at == std::string::npos) {
+    reply.status = 500;
+    return reply;
+  }
+  bool on = request.body[at + 13] == '1';
+  {
+    std::lock_guard<std::mutex> lock(stateLock);
+    outlets[outlet] = on;
+  }
+  reply.body = std::string(
+      "<s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" "
+      "s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\"><s:Body>"
+      "<u:SetBinaryStateResponse xmlns:u=\"urn:Belkin:service:basicevent:1\">"
+      "<BinaryState>") + (on ? "1" : "0") +
+      "</BinaryState></u:SetBinaryStateResponse></s:Body></s:Envelope>";
+  return reply;
+}
+
+/* ------------------------------------------------------------------------ */
+/* HTTP                                                                     */
+/* ------------------------------------------------------------------------ */
+
+//  Read one request off the connection. False if it closed, or sat idle
+//  longer than idleMs (0 waits forever) before the request began.
+static bool readRequest(int sock, std::string &pending, Request &request, int idleMs) {
+  char buffer[1024];
+  size_t headerEnd;
+  while ((headerEnd = pending.find("\r\n\r\n")) == std::string::npos) {
+    if (idleMs > 0 && pending.empty()) {
+      struct pollfd pfd = {sock, POLLIN, 0};
+      if (poll(&pfd, 1, idleMs) != 1) {
+        return false;
+      }
+    }
+    ssize_t n = recv(sock, buffer, sizeof(buffer), 0);
+    if (n <= 0) {
+      return false;
+    }
+    pending.append(buffer, n);
+  }
+
+  std::string head = pending.substr(0, headerEnd);
+  pending.erase(0, headerEnd + 4);
+  size_t lineEnd = head.find("\r\n");
+  std::string line = head.substr(0, lineEnd);
+  size_t space1 = line.find(' ');
+  size_t space2 = line.find(' ', space1 + 1);
+  if (space1 == std::string::npos || space2 == std::string::npos) {
+    return false;
+  }
+  request = Request();
+  request.method = line.substr(0, space1);
+  request.path = line.substr(space1 + 1, space2 - space1 - 1);
+
+  size_t length = 0;
+  while (lineEnd != std::string::npos) {
+    size_t next = head.find("\r\n", lineEnd + 2);
+    std::string header = head.substr(lineEnd + 2, next == std::string::npos ? std::string::npos : next - lineEnd - 2);
+    lineEnd = next;
+    if (strncasecmp(header.c_str(), "Content-Length:", 15) == 0) {
+      length = atoi(header.c_str() + 15);
+    } else if (strncasecmp(header.c_str(), "SOAPACTION:", 11) == 0) {
+      request.soapAction = header.substr(11);
+    } else if (strncasecmp(header.c_str(), "Connection:", 11) == 0 &&
+               header.find("close") != std::string::npos) {
+      request.close = true;
+    }
+  }
+
+  while (pending.size() < length) {
+    ssize_t n = recv(sock, buffer, sizeof(buffer), 0);
+    if (n <= 0) {
+      return false;
+    }
+    pending.append(buffer, n);
+  }
+  request.body = pending.substr(0, length);
+  pending.erase(0, length);
+  return true;
+}
+
+static bool sendAll(int sock, const std::string &data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = send(sock, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      return false;
+    }
+    sent += n;
+  }
+  return true;
+}
+
+static const char *statusText(int status) {
+  switch (status) {
+    case 200: return "OK";
+    case 404: return "Not Found";
+    default: return "Internal Server Error";
+  }
+}
+
+//  Serve one connection. outlet is -1 for the Hue bridge.
+static void serveConnection(int sock, int outlet) {
+  std::mt19937 rng(std::random_device{}());
+  std::uniform_int_distribution<int> percent(0, 99);
+  std::string pending;
+  Request request;
+  int one = 1;
+  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  while (readRequest(sock, pending, request, faults.idleMs)) {
+    int delayMs = faults.latencyMs;
+    if (faults.jitterMs > 0) {
+      delayMs += std::uniform_int_distribution<int>(0, faults.jitterMs)(rng);
+    }
+    if (delayMs > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+    }
+
+    if (percent(rng) < faults.dropPct) {
+      if (verbose) {
+        printf("%s %s %s -> dropped\n", outlet < 0 ? "hue" : "wemo", request.method.c_str(),
+               request.path.c_str());
+      }
+      break;
+    }
+    Reply reply = outlet < 0 ? hueReply(request) : wemoReply(outlet, request);
+    if (percent(rng) < faults.errorPct) {
+      reply.status = 500;
+      reply.body = "";
+    }
+    if (verbose) {
+      if (outlet < 0) {
+        printf("hue %s %s %s -> %d\n", request.method.c_str(), request.path.c_str(),
+               request.body.c_str(), reply.status);
+      } else {
+        printf("wemo #%d %s -> %d\n", outlet, outlets[outlet] ? "on" : "off", reply.status);
+      }
+      fflush(stdout);
+    }
+
+    std::string response = "HTTP/1.1 " + std::to_string(reply.status) + " " + statusText(reply.status) +
+                           "\r\nContent-Type: " + reply.contentType +
+                           "\r\nContent-Length: " + std::to_string(reply.body.size()) +
+                           (request.close ? "\r\nConnection: close" : "") + "\r\n\r\n" + reply.body;
+    if (!sendAll(sock, response) || request.close) {
+      break;
+    }
+  }
+  close(sock);
+}
+
+static int listenOn(const char *address, int port) {
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  inet_pton(AF_INET, address, &addr.sin_addr);
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sock, 16) < 0) {
+    fprintf(stderr, "can't listen on %s:%d: %s\n", address, port, strerror(errno));
+    exit(1);
+  }
+  return sock;
+}
+
+static void acceptLoop(int listener, int outlet) {
+  while (true) {
+    int sock = accept(listener, NULL, NULL);
+    if (sock >= 0) {
+      std::thread(serveConnection, sock, outlet).detach();
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    int *option = NULL;
+    if (strcmp(argv[i], "-v") == 0) {
+      verbose = true;
+    } else if (strcmp(argv[i], "-latency") == 0) {
+      option = &faults.latencyMs;
+    } else if (strcmp(argv[i], "-jitter") == 0) {
+      option = &faults.jitterMs;
+    } else if (strcmp(argv[i], "-errors") == 0) {
+      option = &faults.errorPct;
+    } else if (strcmp(argv[i], "-drops") == 0) {
+      option = &faults.dropPct;
+    } else if (strcmp(argv[i], "-idle") == 0) {
+      option = &faults.idleMs;
+    } else {
+      fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 1;
+    }
+    if (option) {
+      if (++i >= argc) {
+        fprintf(stderr, "%s needs a value\n", argv[i - 1]);
+        return 1;
+      }
+      *option = atoi(argv[i]);
+    }
+  }
+  signal(SIGPIPE, SIG_IGN);
+
+  std::vector<std::thread> listeners;
+  listeners.emplace_back(acceptLoop, listenOn(HUE_ADDRESS, HUE_PORT), -1);
+  for (int outlet = 0; outlet < WEMO_OUTLETS; outlet++) {
+    std::string address = WEMO_ADDRESS_PREFIX + std::to_string(WEMO_FIRST_OCTET + outlet);
+    listeners.emplace_back(acceptLoop, listenOn(address.c_str(), WEMO_PORT), outlet);
+  }
+  printf("Hue bridge on %s:%d, Wemo outlets on %s%d-%d:%d\n", HUE_ADDRESS, HUE_PORT,
+         WEMO_ADDRESS_PREFIX, WEMO_FIRST_OCTET, WEMO_FIRST_OCTET + WEMO_OUTLETS - 1, WEMO_PORT);
+  printf("latency %d ms (+%d jitter), %d%% errors, %d%% drops, idle close %d ms\n",
+         faults.latencyMs, faults.jitterMs, faults.errorPct, faults.dropPct, faults.idleMs);
+  fflush(stdout);
+
+  for (std::thread &listener : listeners) {
+    listener.join();
+  }
+  return 0;
+}
@@ -0,0 +1,512 @@
+/*
+ * Project: Host Particle HAL
+ * Description: Just enough of the Device OS Wiring API to compile the firmware
+ *              and its libraries on a Linux box. Time is virtual (it only
+ *              moves when the simulation or delay() moves it), GPIO and the
+ *              buses are simulated, and TCPClient uses real sockets so the
+ *              network code can talk to local test servers.
+ *              See sim.h for the side of the API the simulation drives.
+*/
+
+#ifndef _HOST_PARTICLE_H_
+#define _HOST_PARTICLE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+
+#ifndef PLATFORM_ID
+#define PLATFORM_ID 32          // P2 / Photon 2
+#endif
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint16_t pin_t;
+typedef uint32_t system_tick_t;
+
+/* ------------------------------------------------------------------------ */
+/* Time                                                                     */
+/* ------------------------------------------------------------------------ */
+
+system_tick_t millis(void);
+system_tick_t micros(void);
+void delay(system_tick_t ms);
+void delayMicroseconds(unsigned int us);
+
+/* ------------------------------------------------------------------------ */
+/* GPIO                                                                     */
+/* ------------------------------------------------------------------------ */
+
+#define LOW  0
+#define HIGH 1
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+typedef enum PinMode {
+  INPUT,
+  OUTPUT,
+  INPUT_PULLUP,
+  INPUT_PULLDOWN,
+  PIN_MODE_NONE = 0xff
+} PinMode;
+
+typedef enum InterruptMode {
+  CHANGE,
+  RISING,
+  FALLING
+} InterruptMode;
+
+// Photon 2 pin numbering
+enum {
+  D0 = 0, D1, D2, D3, D4, D5, D6, D7, D8, D9, D10,
+  D11, D12, D13, D14, D15, D16, D17, D18, D19, D20,
+  A0 = D11, A1 = D12, A2 = D13, A5 = D14,
+  S0 = D15, S1 = D16, S2 = D17, S3 = D18, S4 = D19, S5 = D20,
+  MOSI = D15, MISO = D16, SCK = D17, SS = D18,
+  MOSI1 = D3, MISO1 = D4, SCK1 = D2,
+  SDA = D0, SCL = D1,
+  TOTAL_PINS = 21
+};
+
+#define PIN_INVALID 0xff
+
+void pinMode(pin_t pin, PinMode mode);
+PinMode getPinMode(pin_t pin);
+void digitalWrite(pin_t pin, uint8_t value);
+int32_t digitalRead(pin_t pin);
+inline int32_t pinReadFast(pin_t pin) { return digitalRead(pin); }
+inline void pinSetFast(pin_t pin) { digitalWrite(pin, HIGH); }
+inline void pinResetFast(pin_t pin) { digitalWrite(pin, LOW); }
+void shiftOut(pin_t dataPin, pin_t clockPin, uint8_t bitOrder, uint8_t val);
+
+typedef std::function<void()> wiring_interrupt_handler_t;
+
+bool attachInterrupt(pin_t pin, wiring_interrupt_handler_t handler, InterruptMode mode,
+                     int8_t priority = -1, uint8_t subpriority = 0);
+
+template <typename T>
+bool attachInterrupt(pin_t pin, void (T::*handler)(), T *instance, InterruptMode mode,
+                     int8_t priority = -1, uint8_t subpriority = 0) {
+  return attachInterrupt(pin, [instance, handler]() { (instance->*handler)(); }, mode,
+                         priority, subpriority);
+}
+
+bool detachInterrupt(pin_t pin);
+void noInterrupts(void);
+void interrupts(void);
+
+int map(int value, int fromStart, int fromEnd, int toStart, int toEnd);
+double map(double value, double fromStart, double fromEnd, double toStart, double toEnd);
+
+/* ------------------------------------------------------------------------ */
+/* String / Print / Stream                                                  */
+/* ------------------------------------------------------------------------ */
+
+class String {
+  std::string _s;
+
+ public:
+  String() {}
+  String(const char *s) : _s(s ? s : "") {}
+  String(const std::string &s) : _s(s) {}
+  String(char c) : _s(1, c) {}
+  String(int value, unsigned char base = 10);
+  String(unsigned int value, unsigned char base = 10);
+  String(long value, unsigned char base = 10);
+  String(unsigned long value, unsigned char base = 10);
+  String(double value, int decimalPlaces = 2);
+
+  const char *c_str() const { return _s.c_str(); }
+  unsigned int length() const { return _s.length(); }
+  char charAt(unsigned int index) const { return index < _s.length() ? _s[index] : 0; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  long toInt() const { return atol(_s.c_str()); }
+  float toFloat() const { return atof(_s.c_str()); }
+  int indexOf(const char *s, unsigned int from = 0) const;
+  int indexOf(char c, unsigned int from = 0) const;
+  String substring(unsigned int from) const;
+  String substring(unsigned int from, unsigned int to) const;
+  bool equals(const String &s) const { return _s == s._s; }
+  bool startsWith(const String &s) const { return _s.compare(0, s._s.length(), s._s) == 0; }
+  void reserve(unsigned int size) { _s.reserve(size); }
+  void trim();
+  String &concat(const String &s) { _s += s._s; return *this; }
+
+  String &operator+=(const String &s) { _s += s._s; return *this; }
+  String &operator+=(const char *s) { _s += s; return *this; }
+  String &operator+=(char c) { _s += c; return *this; }
+  String &operator+=(int value) { return *this += String(value); }
+  String &operator+=(long value) { return *this += String(value); }
+  String &operator+=(unsigned int value) { return *this += String(value); }
+  String &operator+=(unsigned long value) { return *this += String(value); }
+
+  friend String operator+(const String &a, const String &b) { return String(a._s + b._s); }
+  friend String operator+(const String &a, const char *b) { return String(a._s + b); }
+  friend String operator+(const char *a, const String &b) { return String(a + b._s); }
+  bool operator==(const String &s) const { return _s == s._s; }
+  bool operator==(const char *s) const { return _s == s; }
+  bool operator!=(const String &s) const { return _s != s._s; }
+  bool operator!=(const char *s) const { return _s != s; }
+};
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+
+  size_t print(const char *s) { return write(s); }
+  size_t print(const String &s) { return write((const uint8_t *)s.c_str(), s.length()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int n, int base = 10) { return print((long)n, base); }
+  size_t print(unsigned int n, int base = 10) { return print((unsigned long)n, base); }
+  size_t print(long n, int base = 10);
+  size_t print(unsigned long n, int base = 10);
+  size_t print(double n, int digits = 2);
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(T value) { size_t n = print(value); return n + println(); }
+  template <typename T>
+  size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  size_t printlnf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  size_t vprintf(bool newline, const char *format, va_list args);
+};
+
+class Stream : public Print {
+ protected:
+  system_tick_t _timeout = 1000;     // real milliseconds, see Stream::timedRead()
+  int timedRead();
+  int timedPeek();
+
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual void flush() = 0;
+
+  void setTimeout(system_tick_t timeout) { _timeout = timeout; }
+  bool find(const char *target);
+  bool findUntil(const char *target, const char *terminator);
+  size_t readBytes(char *buffer, size_t length);
+  size_t readBytesUntil(char terminator, char *buffer, size_t length);
+  long parseInt();
+  String readString();
+  String readStringUntil(char terminator);
+};
+
+/* ------------------------------------------------------------------------ */
+/* Serial and logging                                                       */
+/* ------------------------------------------------------------------------ */
+
+class USBSerial : public Stream {
+ public:
+  void begin(long baud = 9600) { (void)baud; }
+  void end() {}
+  bool isConnected() { return true; }
+  operator bool() { return true; }
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  void flush() override;
+};
+
+extern USBSerial Serial;
+
+class Logger {
+ public:
+  void trace(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  void info(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  void warn(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  void error(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern Logger Log;
+
+template <typename F>
+bool _hostWaitFor(F condition, system_tick_t timeout) {
+  system_tick_t start = millis();
+  while (!condition()) {
+    if ((millis() - start) >= timeout) {
+      return false;
+    }
+    delay(1);
+  }
+  return true;
+}
+
+#define waitFor(condition, timeout) _hostWaitFor([&]() { return (condition)(); }, (timeout))
+#define waitUntil(condition) _hostWaitFor([&]() { return (condition)(); }, 0xffffffff)
+
+/* ------------------------------------------------------------------------ */
+/* System                                                                   */
+/* ------------------------------------------------------------------------ */
+
+#define SYSTEM_MODE(mode)
+#define SYSTEM_THREAD(state)
+
+/* ------------------------------------------------------------------------ */
+/* Threads                                                                  */
+/* ------------------------------------------------------------------------ */
+
+typedef void os_thread_return_t;
+typedef os_thread_return_t (*os_thread_fn_t)(void *param);
+typedef std::function<os_thread_return_t(void)> wiring_thread_fn_t;
+typedef uint8_t os_thread_prio_t;
+
+#define OS_THREAD_PRIORITY_DEFAULT 2
+#define OS_THREAD_STACK_SIZE_DEFAULT 3072
+
+//  Device OS threads run until the device resets. Host threads are detached
+//  so the simulation can exit while they are parked in delay().
+class Thread {
+ public:
+  Thread(const char *name, wiring_thread_fn_t function,
+         os_thread_prio_t priority = OS_THREAD_PRIORITY_DEFAULT,
+         size_t stackSize = OS_THREAD_STACK_SIZE_DEFAULT) {
+    (void)name;
+    (void)priority;
+    (void)stackSize;
+    std::thread(function).detach();
+  }
+  Thread(const char *name, os_thread_fn_t function, void *param = NULL,
+         os_thread_prio_t priority = OS_THREAD_PRIORITY_DEFAULT,
+         size_t stackSize = OS_THREAD_STACK_SIZE_DEFAULT) {
+    (void)name;
+    (void)priority;
+    (void)stackSize;
+    std::thread(function, param).detach();
+  }
+};
+
+//  Semaphores from concurrent_hal.h. A take on the main thread charges the
+//  real time it waited to the virtual clock.
+typedef struct HostSemaphore *os_semaphore_t;
+
+#define CONCURRENT_WAIT_FOREVER ((system_tick_t)-1)
+
+int os_semaphore_create(os_semaphore_t *semaphore, unsigned max, unsigned initial);
+int os_semaphore_destroy(os_semaphore_t semaphore);
+int os_semaphore_take(os_semaphore_t semaphore, system_tick_t timeout, bool reserved);
+int os_semaphore_give(os_semaphore_t semaphore, bool reserved);
+
+class Mutex {
+  std::mutex _mutex;
+
+ public:
+  void lock() { _mutex.lock(); }
+  bool trylock() { return _mutex.try_lock(); }
+  bool try_lock() { return _mutex.try_lock(); }
+  void unlock() { _mutex.unlock(); }
+};
+
+/* ------------------------------------------------------------------------ */
+/* I2C                                                                      */
+/* ------------------------------------------------------------------------ */
+
+#define I2C_BUFFER_LENGTH 32
+
+#define CLOCK_SPEED_100KHZ 100000
+#define CLOCK_SPEED_400KHZ 400000
+
+#define HAL_I2C_CONFIG_VERSION_1 1
+
+typedef struct hal_i2c_config_t {
+  uint16_t size;
+  uint16_t version;
+  uint8_t *rx_buffer;
+  uint32_t rx_buffer_size;
+  uint8_t *tx_buffer;
+  uint32_t tx_buffer_size;
+} hal_i2c_config_t;
+
+//  Defined by the application to give Wire bigger buffers; the default
+//  (weak) one keeps I2C_BUFFER_LENGTH
+hal_i2c_config_t acquireWireBuffer();
+
+class TwoWire : public Stream {
+  uint32_t _clock = CLOCK_SPEED_100KHZ;
+  uint8_t _address = 0;
+  uint8_t *_txBuffer = nullptr;
+  size_t _txSize = 0;
+  size_t _txLength = 0;
+  bool _transmitting = false;
+  bool _enabled = false;
+
+  void acquireBuffer();
+
+ public:
+  void begin() { acquireBuffer(); _enabled = true; }
+  void end() { _enabled = false; }
+  bool isEnabled() { return _enabled; }
+  void setSpeed(uint32_t clock) { _clock = clock; }
+  void setClock(uint32_t clock) { _clock = clock; }
+
+  void beginTransmission(uint8_t address);
+  void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+  uint8_t endTransmission(uint8_t sendStop = true);
+  size_t write(uint8_t data) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = true);
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  void flush() override {}
+};
+
+extern TwoWire Wire;
+
+/* ------------------------------------------------------------------------ */
+/* SPI                                                                      */
+/* ------------------------------------------------------------------------ */
+
+typedef enum hal_spi_interface_t {
+  HAL_SPI_INTERFACE1 = 0,
+  HAL_SPI_INTERFACE2 = 1
+} hal_spi_interface_t;
+
+#define HAL_PLATFORM_SPI_NUM 2
+
+typedef enum hal_spi_mode_t {
+  SPI_MODE_MASTER = 0,
+  SPI_MODE_SLAVE = 1
+} hal_spi_mode_t;
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x01
+#define SPI_MODE2 0x02
+#define SPI_MODE3 0x03
+
+#define SPI_CLOCK_DIV2   0x00
+#define SPI_CLOCK_DIV4   0x08
+#define SPI_CLOCK_DIV8   0x10
+#define SPI_CLOCK_DIV16  0x18
+#define SPI_CLOCK_DIV32  0x20
+#define SPI_CLOCK_DIV64  0x28
+#define SPI_CLOCK_DIV128 0x30
+#define SPI_CLOCK_DIV256 0x38
+
+#define HAL_SPI_CONFIG_VERSION 1
+#define HAL_SPI_CONFIG_FLAG_MOSI_ONLY 0x01
+
+typedef struct hal_spi_config_t {
+  uint16_t size;
+  uint16_t version;
+  uint32_t flags;
+} hal_spi_config_t;
+
+int hal_spi_begin_ext(hal_spi_interface_t spi, hal_spi_mode_t mode, pin_t ssPin,
+                      const hal_spi_config_t *config);
+
+typedef void (*wiring_spi_dma_transfercomplete_callback_t)(void);
+
+class SPIClass {
+  hal_spi_interface_t _interface;
+  uint32_t _clock = 0;
+  //  A transfer with a callback runs as DMA: it returns at once and the
+  //  callback fires once the virtual clock passes the end of the transfer.
+  wiring_spi_dma_transfercomplete_callback_t _dmaCallback = nullptr;
+  uint64_t _dmaDoneUs = 0;
+
+ public:
+  explicit SPIClass(hal_spi_interface_t interface) : _interface(interface) {}
+
+  hal_spi_interface_t interface() const { return _interface; }
+  void begin() {}
+  void begin(pin_t ssPin) { (void)ssPin; }
+  void end() {}
+  void setBitOrder(uint8_t order) { (void)order; }
+  void setDataMode(uint8_t mode) { (void)mode; }
+  void setClockDivider(uint8_t divider) { (void)divider; }
+  void setClockSpeed(unsigned value, unsigned scale = 1) { _clock = value * scale; }
+  int32_t beginTransaction() { return 0; }
+  void endTransaction() {}
+
+  uint8_t transfer(uint8_t data);
+  void transfer(const void *txBuffer, void *rxBuffer, size_t length,
+                wiring_spi_dma_transfercomplete_callback_t userCallback);
+
+  void completeDma(bool wait);
+};
+
+extern SPIClass SPI;
+extern SPIClass SPI1;
+
+/* ------------------------------------------------------------------------ */
+/* Networking                                                               */
+/* ------------------------------------------------------------------------ */
+
+class IPAddress {
+  uint8_t _octets[4];
+
+ public:
+  IPAddress() : _octets{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _octets{a, b, c, d} {}
+  uint8_t operator[](int index) const { return _octets[index]; }
+  operator bool() const { return _octets[0] || _octets[1] || _octets[2] || _octets[3]; }
+};
+
+class WiFiClass {
+ public:
+  void on();
+  void off();
+  void connect();
+  void disconnect();
+  bool connecting() { return false; }
+  bool ready();
+  void clearCredentials() {}
+  void setCredentials(const char *ssid) { (void)ssid; }
+  void setCredentials(const char *ssid, const char *password) { (void)ssid; (void)password; }
+};
+
+extern WiFiClass WiFi;
+
+class TCPClient : public Stream {
+  int _sock = -1;
+  int _peeked = -1;
+
+  int openSocket(const char *host, uint16_t port);
+
+ public:
+  TCPClient() {}
+  ~TCPClient() { stop(); }
+  TCPClient(const TCPClient &) = delete;
+  TCPClient &operator=(const TCPClient &) = delete;
+
+  int connect(const char *host, uint16_t port);
+  int connect(IPAddress ip, uint16_t port);
+  uint8_t connected();
+  uint8_t status() { return connected(); }
+  void stop();
+  operator bool() { return connected(); }
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buffer, size_t size);
+  int peek() override;
+  void flush() override {}
+};
+
+#endif // _HOST_PARTICLE_H_
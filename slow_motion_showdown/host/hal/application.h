@@ -0,0 +1,6 @@
+#ifndef _HOST_APPLICATION_H_
+#define _HOST_APPLICATION_H_
+
+#include "Particle.h"
+
+#endif // _HOST_APPLICATION_H_
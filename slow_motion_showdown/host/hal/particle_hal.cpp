@@ -0,0 +1,1123 @@
+/*
+ * Project: Host Particle HAL
+ * Description: Simulated clock, GPIO, I2C (with an SSD1306 panel model on
+ *              0x3C/0x3D), SPI, Serial and socket backed TCPClient.
+*/
+
+#include "Particle.h"
+#include "sim.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+
+/* ------------------------------------------------------------------------ */
+/* Virtual clock                                                            */
+/* ------------------------------------------------------------------------ */
+
+static std::atomic<uint64_t> nowUs(0);
+static bool busTiming = true;
+
+//  The first thread to touch the HAL is the one running setup()/loop()
+//  (global constructors already call into it), and it owns the clock.
+static bool isMainThread() {
+  static const std::thread::id mainThread = std::this_thread::get_id();
+  return std::this_thread::get_id() == mainThread;
+}
+
+static void completeDueDma();
+
+//  Everything that moves the clock forward goes through here, so DMA
+//  completion callbacks fire on time.
+static void advanceClock(uint64_t us) {
+  nowUs += us;
+  completeDueDma();
+}
+
+static void chargeBusTime(uint64_t us) {
+  if (busTiming && isMainThread()) {
+    advanceClock(us);
+  }
+}
+
+system_tick_t millis(void) {
+  return (system_tick_t)(nowUs.load() / 1000);
+}
+
+system_tick_t micros(void) {
+  return (system_tick_t)nowUs.load();
+}
+
+void delay(system_tick_t ms) {
+  if (isMainThread()) {
+    advanceClock((uint64_t)ms * 1000);
+  } else {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  }
+}
+
+void delayMicroseconds(unsigned int us) {
+  if (isMainThread()) {
+    advanceClock(us);
+  } else {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  }
+}
+
+/* ------------------------------------------------------------------------ */
+/* Threads                                                                  */
+/* ------------------------------------------------------------------------ */
+
+struct HostSemaphore {
+  std::mutex mutex;
+  std::condition_variable ready;
+  unsigned count;
+  unsigned max;
+};
+
+int os_semaphore_create(os_semaphore_t *semaphore, unsigned max, unsigned initial) {
+  *semaphore = new HostSemaphore();
+  (*semaphore)->count = initial;
+  (*semaphore)->max = max;
+  return 0;
+}
+
+int os_semaphore_destroy(os_semaphore_t semaphore) {
+  delete semaphore;
+  return 0;
+}
+
+//  A wait on the main thread moves the virtual clock along with real time,
+//  a slice at a time, so worker threads timing their own requests with
+//  millis() see it pass as they would on the device rather than in one
+//  jump when the wait ends.
+int os_semaphore_take(os_semaphore_t semaphore, system_tick_t timeout, bool reserved) {
+  (void)reserved;
+  const auto slice = std::chrono::milliseconds(1);
+  bool main = isMainThread();
+  auto start = std::chrono::steady_clock::now();
+  auto charged = start;
+  auto giveUp = start + std::chrono::milliseconds(timeout);
+  std::unique_lock<std::mutex> lock(semaphore->mutex);
+  bool taken = semaphore->count > 0;
+  while (!taken) {
+    auto now = std::chrono::steady_clock::now();
+    if (timeout != CONCURRENT_WAIT_FOREVER && now >= giveUp) {
+      break;
+    }
+    if (!main) {
+      if (timeout == CONCURRENT_WAIT_FOREVER) {
+        semaphore->ready.wait(lock, [&] { return semaphore->count > 0; });
+      } else {
+        semaphore->ready.wait_until(lock, giveUp, [&] { return semaphore->count > 0; });
+      }
+    } else {
+      auto until = now + slice;
+      if (timeout != CONCURRENT_WAIT_FOREVER && giveUp < until) {
+        until = giveUp;
+      }
+      semaphore->ready.wait_until(lock, until, [&] { return semaphore->count > 0; });
+      now = std::chrono::steady_clock::now();
+      lock.unlock();
+      advanceClock(std::chrono::duration_cast<std::chrono::microseconds>(now - charged).count());
+      lock.lock();
+      charged = now;
+    }
+    taken = semaphore->count > 0;
+  }
+  if (taken) {
+    semaphore->count--;
+  }
+  return taken ? 0 : 1;
+}
+
+int os_semaphore_give(os_semaphore_t semaphore, bool reserved) {
+  (void)reserved;
+  std::lock_guard<std::mutex> lock(semaphore->mutex);
+  if (semaphore->count >= semaphore->max) {
+    return 1;
+  }
+  semaphore->count++;
+  semaphore->ready.notify_one();
+  return 0;
+}
+
+/* ------------------------------------------------------------------------ */
+/* GPIO and interrupts                                                      */
+/* ------------------------------------------------------------------------ */
+
+struct PinState {
+  PinMode mode = PIN_MODE_NONE;
+  bool output = false;          // level written by the firmware
+  bool driven = false;          // level forced from outside by the simulation
+  bool input = false;
+  bool attached = false;
+  InterruptMode edge = CHANGE;
+  wiring_interrupt_handler_t handler;
+};
+
+static PinState pins[TOTAL_PINS];
+static uint64_t pinChanges = 0;
+static bool interruptsEnabled = true;
+static std::vector<wiring_interrupt_handler_t> pendingInterrupts;
+
+void pinMode(pin_t pin, PinMode mode) {
+  if (pin < TOTAL_PINS) {
+    pins[pin].mode = mode;
+  }
+}
+
+PinMode getPinMode(pin_t pin) {
+  return pin < TOTAL_PINS ? pins[pin].mode : PIN_MODE_NONE;
+}
+
+void digitalWrite(pin_t pin, uint8_t value) {
+  if (pin < TOTAL_PINS) {
+    if (pins[pin].output != (value != 0)) {
+      pinChanges++;
+    }
+    pins[pin].output = value;
+  }
+}
+
+int32_t digitalRead(pin_t pin) {
+  if (pin >= TOTAL_PINS) {
+    return LOW;
+  }
+  const PinState &p = pins[pin];
+  if (p.driven) {
+    return p.input;
+  }
+  switch (p.mode) {
+    case OUTPUT:
+      return p.output;
+    case INPUT_PULLUP:
+      return HIGH;
+    default:
+      return LOW;
+  }
+}
+
+void shiftOut(pin_t dataPin, pin_t clockPin, uint8_t bitOrder, uint8_t val) {
+  for (int i = 0; i < 8; i++) {
+    digitalWrite(dataPin, (bitOrder == LSBFIRST) ? (val >> i) & 1 : (val >> (7 - i)) & 1);
+    digitalWrite(clockPin, HIGH);
+    digitalWrite(clockPin, LOW);
+  }
+}
+
+bool attachInterrupt(pin_t pin, wiring_interrupt_handler_t handler, InterruptMode mode,
+                     int8_t priority, uint8_t subpriority) {
+  (void)priority;
+  (void)subpriority;
+  if (pin >= TOTAL_PINS) {
+    return false;
+  }
+  pins[pin].attached = true;
+  pins[pin].edge = mode;
+  pins[pin].handler = handler;
+  return true;
+}
+
+bool detachInterrupt(pin_t pin) {
+  if (pin >= TOTAL_PINS) {
+    return false;
+  }
+  pins[pin].attached = false;
+  pins[pin].handler = nullptr;
+  return true;
+}
+
+void noInterrupts(void) {
+  interruptsEnabled = false;
+}
+
+void interrupts(void) {
+  interruptsEnabled = true;
+  std::vector<wiring_interrupt_handler_t> pending;
+  pending.swap(pendingInterrupts);
+  for (auto &handler : pending) {
+    handler();
+  }
+}
+
+static void driveInput(pin_t pin, bool driven, bool level) {
+  if (pin >= TOTAL_PINS) {
+    return;
+  }
+  PinState &p = pins[pin];
+  bool before = digitalRead(pin);
+  p.driven = driven;
+  p.input = level;
+  bool after = digitalRead(pin);
+
+  if (!p.attached || before == after) {
+    return;
+  }
+  if (p.edge == CHANGE || (p.edge == RISING && after) || (p.edge == FALLING && !after)) {
+    if (interruptsEnabled) {
+      p.handler();
+    } else {
+      pendingInterrupts.push_back(p.handler);
+    }
+  }
+}
+
+int map(int value, int fromStart, int fromEnd, int toStart, int toEnd) {
+  if (fromEnd == fromStart) {
+    return value;
+  }
+  return (value - fromStart) * (toEnd - toStart) / (fromEnd - fromStart) + toStart;
+}
+
+double map(double value, double fromStart, double fromEnd, double toStart, double toEnd) {
+  if (fromEnd == fromStart) {
+    return value;
+  }
+  return (value - fromStart) * (toEnd - toStart) / (fromEnd - fromStart) + toStart;
+}
+
+/* ------------------------------------------------------------------------ */
+/* String                                                                   */
+/* ------------------------------------------------------------------------ */
+
+static std::string formatInteger(unsigned long value, bool negative, unsigned char base) {
+  char digits[sizeof(unsigned long) * 8 + 2];
+  int i = sizeof(digits) - 1;
+  digits[i] = '\0';
+  if (base < 2) {
+    base = 10;
+  }
+  do {
+    int d = value % base;
+    digits[--i] = d < 10 ? '0' + d : 'A' + d - 10;
+    value /= base;
+  } while (value);
+  if (negative) {
+    digits[--i] = '-';
+  }
+  return std::string(&digits[i]);
+}
+
+String::String(int value, unsigned char base) : String((long)value, base) {}
+
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base) {}
+
+String::String(long value, unsigned char base) {
+  if (value < 0 && base == 10) {
+    _s = formatInteger(-(unsigned long)value, true, base);
+  } else {
+    _s = formatInteger((unsigned long)value, false, base);
+  }
+}
+
+String::String(unsigned long value, unsigned char base) : _s(formatInteger(value, false, base)) {}
+
+String::String(double value, int decimalPlaces) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+  _s = buf;
+}
+
+int String::indexOf(const char *s, unsigned int from) const {
+  size_t found = _s.find(s, from);
+  return found == std::string::npos ? -1 : (int)found;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+  size_t found = _s.find(c, from);
+  return found == std::string::npos ? -1 : (int)found;
+}
+
+String String::substring(unsigned int from) const {
+  return from < _s.length() ? String(_s.substr(from)) : String();
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if (from > to) {
+    std::swap(from, to);
+  }
+  if (from >= _s.length()) {
+    return String();
+  }
+  return String(_s.substr(from, to - from));
+}
+
+void String::trim() {
+  size_t start = _s.find_first_not_of(" \t\r\n");
+  size_t end = _s.find_last_not_of(" \t\r\n");
+  _s = (start == std::string::npos) ? std::string() : _s.substr(start, end - start + 1);
+}
+
+/* ------------------------------------------------------------------------ */
+/* Print / Stream                                                           */
+/* ------------------------------------------------------------------------ */
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::print(long n, int base) {
+  return print(String(n, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long n, int base) {
+  return print(String(n, (unsigned char)base));
+}
+
+size_t Print::print(double n, int digits) {
+  return print(String(n, digits));
+}
+
+size_t Print::vprintf(bool newline, const char *format, va_list args) {
+  char stackBuf[128];
+  va_list copy;
+  va_copy(copy, args);
+  int len = vsnprintf(stackBuf, sizeof(stackBuf), format, copy);
+  va_end(copy);
+  if (len < 0) {
+    return 0;
+  }
+
+  size_t n;
+  if ((size_t)len < sizeof(stackBuf)) {
+    n = write((const uint8_t *)stackBuf, len);
+  } else {
+    std::vector<char> heapBuf(len + 1);
+    vsnprintf(heapBuf.data(), heapBuf.size(), format, args);
+    n = write((const uint8_t *)heapBuf.data(), len);
+  }
+  if (newline) {
+    n += println();
+  }
+  return n;
+}
+
+size_t Print::printf(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  size_t n = vprintf(false, format, args);
+  va_end(args);
+  return n;
+}
+
+size_t Print::printlnf(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  size_t n = vprintf(true, format, args);
+  va_end(args);
+  return n;
+}
+
+//  Streams are only backed by real sockets here, so their timeouts run on
+//  the real clock; the virtual clock would never move while we wait.
+int Stream::timedRead() {
+  auto start = std::chrono::steady_clock::now();
+  do {
+    int c = read();
+    if (c >= 0) {
+      return c;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  } while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(_timeout));
+  return -1;
+}
+
+int Stream::timedPeek() {
+  auto start = std::chrono::steady_clock::now();
+  do {
+    int c = peek();
+    if (c >= 0) {
+      return c;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  } while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(_timeout));
+  return -1;
+}
+
+bool Stream::find(const char *target) {
+  return findUntil(target, NULL);
+}
+
+bool Stream::findUntil(const char *target, const char *terminator) {
+  size_t targetLen = strlen(target);
+  size_t termLen = terminator ? strlen(terminator) : 0;
+  size_t index = 0, termIndex = 0;
+
+  if (targetLen == 0) {
+    return true;
+  }
+  int c;
+  while ((c = timedRead()) >= 0) {
+    if (c == target[index]) {
+      if (++index >= targetLen) {
+        return true;
+      }
+    } else {
+      index = (c == target[0]) ? 1 : 0;
+    }
+    if (termLen > 0 && c == terminator[termIndex]) {
+      if (++termIndex >= termLen) {
+        return false;
+      }
+    } else {
+      termIndex = 0;
+    }
+  }
+  return false;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = timedRead();
+    if (c < 0) {
+      break;
+    }
+    buffer[count++] = (char)c;
+  }
+  return count;
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = timedRead();
+    if (c < 0 || c == terminator) {
+      break;
+    }
+    buffer[count++] = (char)c;
+  }
+  return count;
+}
+
+long Stream::parseInt() {
+  int c;
+  while ((c = timedPeek()) >= 0 && c != '-' && (c < '0' || c > '9')) {
+    read();
+  }
+  bool negative = false;
+  long value = 0;
+  while ((c = timedPeek()) >= 0) {
+    if (c == '-' && value == 0 && !negative) {
+      negative = true;
+    } else if (c >= '0' && c <= '9') {
+      value = value * 10 + (c - '0');
+    } else {
+      break;
+    }
+    read();
+  }
+  return negative ? -value : value;
+}
+
+String Stream::readString() {
+  std::string s;
+  int c;
+  while ((c = timedRead()) >= 0) {
+    s += (char)c;
+  }
+  return String(s);
+}
+
+String Stream::readStringUntil(char terminator) {
+  std::string s;
+  int c;
+  while ((c = timedRead()) >= 0 && c != terminator) {
+    s += (char)c;
+  }
+  return String(s);
+}
+
+/* ------------------------------------------------------------------------ */
+/* Serial and logging                                                       */
+/* ------------------------------------------------------------------------ */
+
+USBSerial Serial;
+Logger Log;
+static bool serialEcho = false;
+static std::mutex serialLock;
+
+size_t USBSerial::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t USBSerial::write(const uint8_t *buffer, size_t size) {
+  if (serialEcho) {
+    std::lock_guard<std::mutex> lock(serialLock);
+    fwrite(buffer, 1, size, stdout);
+  }
+  return size;
+}
+
+void USBSerial::flush() {
+  if (serialEcho) {
+    fflush(stdout);
+  }
+}
+
+static void logLine(const char *level, const char *format, va_list args) {
+  if (!serialEcho) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(serialLock);
+  fprintf(stdout, "%010lu [app] %s: ", (unsigned long)millis(), level);
+  vfprintf(stdout, format, args);
+  fputc('\n', stdout);
+}
+
+#define LOGGER_METHOD(name, level)                \
+  void Logger::name(const char *format, ...) {    \
+    va_list args;                                 \
+    va_start(args, format);                       \
+    logLine(level, format, args);                 \
+    va_end(args);                                 \
+  }
+
+LOGGER_METHOD(trace, "TRACE")
+LOGGER_METHOD(info, "INFO")
+LOGGER_METHOD(warn, "WARN")
+LOGGER_METHOD(error, "ERROR")
+
+/* ------------------------------------------------------------------------ */
+/* I2C and the SSD1306 panel model                                          */
+/* ------------------------------------------------------------------------ */
+
+static sim::BusStats i2cBus = {};
+
+//  Enough of the SSD1306 command set to track what the panel would show:
+//  addressing modes, column/page windows and data writes into GDDRAM.
+//  Command parameters may arrive in later transactions, like on the chip.
+class Ssd1306Panel {
+  uint8_t _ram[128 * 8] = {};
+  uint8_t _command = 0;
+  uint8_t _argsNeeded = 0;
+  uint8_t _argCount = 0;
+  uint8_t _args[6] = {};
+  uint8_t _mode = 2;            // page addressing after reset
+  uint8_t _colStart = 0, _colEnd = 127, _pageStart = 0, _pageEnd = 7;
+  uint8_t _col = 0, _page = 0;
+
+  static uint8_t argumentCount(uint8_t c) {
+    switch (c) {
+      case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+      case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+        return 1;
+      case 0x21: case 0x22: case 0xA3:
+        return 2;
+      case 0x29: case 0x2A:
+        return 5;
+      case 0x26: case 0x27:
+        return 6;
+      default:
+        return 0;
+    }
+  }
+
+  void runCommand() {
+    switch (_command) {
+      case 0x20:
+        _mode = _args[0] & 3;
+        break;
+      case 0x21:
+        _colStart = _col = _args[0] & 0x7F;
+        _colEnd = _args[1] & 0x7F;
+        break;
+      case 0x22:
+        _pageStart = _page = _args[0] & 7;
+        _pageEnd = _args[1] & 7;
+        break;
+      default:
+        if (_command >= 0xB0 && _command <= 0xB7) {
+          _page = _command & 7;
+        } else if (_command <= 0x0F) {
+          _col = (_col & 0xF0) | _command;
+        } else if (_command >= 0x10 && _command <= 0x1F) {
+          _col = ((_command & 0x07) << 4) | (_col & 0x0F);
+        }
+        break;
+    }
+  }
+
+  void command(uint8_t c) {
+    if (_argsNeeded) {
+      _args[_argCount++] = c;
+      if (--_argsNeeded == 0) {
+        runCommand();
+      }
+      return;
+    }
+    _command = c;
+    _argCount = 0;
+    _argsNeeded = argumentCount(c);
+    if (_argsNeeded == 0) {
+      runCommand();
+    }
+  }
+
+  void data(uint8_t d) {
+    _ram[_page * 128 + _col] = d;
+    switch (_mode) {
+      case 0:                   // horizontal: wrap within the window
+        if (_col++ >= _colEnd) {
+          _col = _colStart;
+          _page = (_page >= _pageEnd) ? _pageStart : _page + 1;
+        }
+        break;
+      case 1:                   // vertical
+        if (_page++ >= _pageEnd) {
+          _page = _pageStart;
+          _col = (_col >= _colEnd) ? _colStart : _col + 1;
+        }
+        break;
+      default:                  // page: column wraps, page stays
+        _col = (_col + 1) & 0x7F;
+        break;
+    }
+  }
+
+ public:
+  const uint8_t *ram() const { return _ram; }
+
+  //  One I2C transaction: control byte(s) followed by commands or data.
+  void transaction(const uint8_t *bytes, size_t length) {
+    size_t i = 0;
+    while (i < length) {
+      uint8_t control = bytes[i++];
+      bool continuation = control & 0x80;
+      bool isData = control & 0x40;
+      if (continuation) {
+        if (i < length) {
+          isData ? data(bytes[i]) : command(bytes[i]);
+          i++;
+        }
+        continue;
+      }
+      for (; i < length; i++) {
+        isData ? data(bytes[i]) : command(bytes[i]);
+      }
+    }
+  }
+};
+
+static Ssd1306Panel panel3C, panel3D;
+
+static Ssd1306Panel *panelAt(uint8_t address) {
+  if (address == 0x3C) {
+    return &panel3C;
+  }
+  if (address == 0x3D) {
+    return &panel3D;
+  }
+  return NULL;
+}
+
+TwoWire Wire;
+
+__attribute__((weak)) hal_i2c_config_t acquireWireBuffer() {
+  return {sizeof(hal_i2c_config_t), HAL_I2C_CONFIG_VERSION_1, NULL, I2C_BUFFER_LENGTH,
+          NULL, I2C_BUFFER_LENGTH};
+}
+
+//  Like Device OS, ask the application for the buffers on first use
+void TwoWire::acquireBuffer() {
+  static uint8_t defaultTx[I2C_BUFFER_LENGTH];
+  if (_txBuffer) {
+    return;
+  }
+  hal_i2c_config_t config = acquireWireBuffer();
+  if (config.tx_buffer && config.tx_buffer_size) {
+    _txBuffer = config.tx_buffer;
+    _txSize = config.tx_buffer_size;
+  } else {
+    _txBuffer = defaultTx;
+    _txSize = sizeof(defaultTx);
+  }
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  acquireBuffer();
+  _address = address;
+  _txLength = 0;
+  _transmitting = true;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (!_transmitting || _txLength >= _txSize) {
+    return 0;
+  }
+  _txBuffer[_txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (n < size && write(buffer[n])) {
+    n++;
+  }
+  return n;
+}
+
+uint8_t TwoWire::endTransmission(uint8_t sendStop) {
+  (void)sendStop;
+  if (!_transmitting) {
+    return 4;
+  }
+  _transmitting = false;
+
+  // address byte + payload, 9 clocks per byte, plus start and stop
+  uint64_t bits = (uint64_t)(_txLength + 1) * 9 + 2;
+  uint64_t us = (bits * 1000000 + _clock - 1) / _clock;
+  i2cBus.transactions++;
+  i2cBus.bytes += _txLength + 1;
+  i2cBus.busMicros += us;
+  chargeBusTime(us);
+
+  Ssd1306Panel *panel = panelAt(_address);
+  if (!panel) {
+    return 2;                   // address NACK
+  }
+  panel->transaction(_txBuffer, _txLength);
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop) {
+  (void)address;
+  (void)quantity;
+  (void)sendStop;
+  return 0;
+}
+
+/* ------------------------------------------------------------------------ */
+/* SPI                                                                      */
+/* ------------------------------------------------------------------------ */
+
+static sim::BusStats spiBus = {};
+
+SPIClass SPI(HAL_SPI_INTERFACE1);
+SPIClass SPI1(HAL_SPI_INTERFACE2);
+
+int hal_spi_begin_ext(hal_spi_interface_t spi, hal_spi_mode_t mode, pin_t ssPin,
+                      const hal_spi_config_t *config) {
+  (void)spi;
+  (void)mode;
+  (void)ssPin;
+  (void)config;
+  return 0;
+}
+
+static uint64_t spiMicros(size_t length, uint32_t clock) {
+  if (clock == 0) {
+    clock = 1000000;
+  }
+  uint64_t us = ((uint64_t)length * 8 * 1000000 + clock - 1) / clock;
+  spiBus.transactions++;
+  spiBus.bytes += length;
+  spiBus.busMicros += us;
+  return us;
+}
+
+//  Fire the callback of a finished DMA transfer. With wait, first run the
+//  clock up to the end of one still in flight, as a new transfer would.
+void SPIClass::completeDma(bool wait) {
+  if (!_dmaCallback) {
+    return;
+  }
+  if (wait && nowUs.load() < _dmaDoneUs && isMainThread()) {
+    nowUs = _dmaDoneUs;
+  }
+  if (nowUs.load() >= _dmaDoneUs) {
+    wiring_spi_dma_transfercomplete_callback_t callback = _dmaCallback;
+    _dmaCallback = nullptr;
+    callback();
+  }
+}
+
+static void completeDueDma() {
+  SPI.completeDma(false);
+  SPI1.completeDma(false);
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+  completeDma(true);
+  chargeBusTime(spiMicros(1, _clock));
+  (void)data;
+  return 0;
+}
+
+void SPIClass::transfer(const void *txBuffer, void *rxBuffer, size_t length,
+                        wiring_spi_dma_transfercomplete_callback_t userCallback) {
+  (void)txBuffer;
+  completeDma(true);
+  if (rxBuffer) {
+    memset(rxBuffer, 0, length);
+  }
+  uint64_t us = spiMicros(length, _clock);
+  if (userCallback) {
+    _dmaCallback = userCallback;
+    _dmaDoneUs = nowUs.load() + us;
+  } else {
+    chargeBusTime(us);
+  }
+}
+
+/* ------------------------------------------------------------------------ */
+/* Networking                                                               */
+/* ------------------------------------------------------------------------ */
+
+static std::atomic<bool> networkReady(false);
+static const int CONNECT_TIMEOUT_MS = 5000;
+
+//  Network round trips really happen, so when the main thread waits on a
+//  socket the virtual clock moves by the real time the wait took.
+static void chargeNetworkWait(std::chrono::steady_clock::time_point start) {
+  if (isMainThread()) {
+    advanceClock(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+  }
+}
+
+WiFiClass WiFi;
+
+void WiFiClass::on() {}
+void WiFiClass::off() {}
+void WiFiClass::connect() {}
+void WiFiClass::disconnect() {}
+
+bool WiFiClass::ready() {
+  return networkReady;
+}
+
+int TCPClient::connect(const char *host, uint16_t port) {
+  stop();
+  if (!networkReady) {
+    return 0;
+  }
+  auto start = std::chrono::steady_clock::now();
+  int connected = openSocket(host, port);
+  chargeNetworkWait(start);
+  return connected;
+}
+
+int TCPClient::openSocket(const char *host, uint16_t port) {
+  struct addrinfo hints = {}, *res = NULL;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  char service[8];
+  snprintf(service, sizeof(service), "%u", port);
+  if (getaddrinfo(host, service, &hints, &res) != 0 || !res) {
+    return 0;
+  }
+
+  int sock = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  if (sock < 0) {
+    freeaddrinfo(res);
+    return 0;
+  }
+  int flags = fcntl(sock, F_GETFL, 0);
+  fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+
+  int rc = ::connect(sock, res->ai_addr, res->ai_addrlen);
+  freeaddrinfo(res);
+  if (rc < 0 && errno == EINPROGRESS) {
+    struct pollfd pfd = {sock, POLLOUT, 0};
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (poll(&pfd, 1, CONNECT_TIMEOUT_MS) == 1 &&
+        getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0) {
+      rc = 0;
+    }
+  }
+  if (rc < 0) {
+    close(sock);
+    return 0;
+  }
+
+  fcntl(sock, F_SETFL, flags);
+  int one = 1;
+  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  _sock = sock;
+  _peeked = -1;
+  return 1;
+}
+
+int TCPClient::connect(IPAddress ip, uint16_t port) {
+  char host[16];
+  snprintf(host, sizeof(host), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  return connect(host, port);
+}
+
+uint8_t TCPClient::connected() {
+  if (_sock < 0) {
+    return false;
+  }
+  if (_peeked >= 0) {
+    return true;
+  }
+  char c;
+  ssize_t n = recv(_sock, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))) {
+    return true;
+  }
+  return false;
+}
+
+void TCPClient::stop() {
+  if (_sock >= 0) {
+    close(_sock);
+    _sock = -1;
+  }
+  _peeked = -1;
+}
+
+size_t TCPClient::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t TCPClient::write(const uint8_t *buffer, size_t size) {
+  if (_sock < 0) {
+    return 0;
+  }
+  size_t sent = 0;
+  while (sent < size) {
+    ssize_t n = send(_sock, buffer + sent, size - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      break;
+    }
+    sent += n;
+  }
+  return sent;
+}
+
+//  On the main thread an empty socket is given up to a millisecond for data
+//  to arrive, so firmware polling for a reply sees time pass.
+int TCPClient::available() {
+  if (_sock < 0) {
+    return 0;
+  }
+  int count = 0;
+  if (ioctl(_sock, FIONREAD, &count) < 0) {
+    count = 0;
+  }
+  if (_peeked >= 0) {
+    return count + 1;
+  }
+  if (count == 0 && isMainThread()) {
+    auto start = std::chrono::steady_clock::now();
+    struct pollfd pfd = {_sock, POLLIN, 0};
+    if (poll(&pfd, 1, 1) == 1 && ioctl(_sock, FIONREAD, &count) < 0) {
+      count = 0;
+    }
+    chargeNetworkWait(start);
+  }
+  return count;
+}
+
+int TCPClient::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int TCPClient::read(uint8_t *buffer, size_t size) {
+  if (_sock < 0 || size == 0) {
+    return -1;
+  }
+  size_t count = 0;
+  if (_peeked >= 0) {
+    buffer[count++] = (uint8_t)_peeked;
+    _peeked = -1;
+  }
+  if (count < size) {
+    ssize_t n = recv(_sock, buffer + count, size - count, MSG_DONTWAIT);
+    if (n > 0) {
+      count += n;
+    }
+  }
+  return count > 0 ? (int)count : -1;
+}
+
+int TCPClient::peek() {
+  if (_peeked < 0) {
+    _peeked = read();
+  }
+  return _peeked;
+}
+
+/* ------------------------------------------------------------------------ */
+/* Simulation control                                                       */
+/* ------------------------------------------------------------------------ */
+
+namespace sim {
+
+uint64_t nowMicros() {
+  return nowUs.load();
+}
+
+void advanceMicros(uint64_t us) {
+  advanceClock(us);
+}
+
+void setInput(pin_t pin, bool level) {
+  driveInput(pin, true, level);
+}
+
+void releaseInput(pin_t pin) {
+  driveInput(pin, false, false);
+}
+
+bool outputLevel(pin_t pin) {
+  return pin < TOTAL_PINS && pins[pin].mode == OUTPUT && pins[pin].output;
+}
+
+uint64_t outputChanges() {
+  return pinChanges;
+}
+
+void setBusTiming(bool enabled) {
+  busTiming = enabled;
+}
+
+void setNetworkReady(bool ready) {
+  networkReady = ready;
+}
+
+void setSerialEcho(bool enabled) {
+  serialEcho = enabled;
+}
+
+BusStats i2cStats() {
+  return i2cBus;
+}
+
+BusStats spiStats() {
+  return spiBus;
+}
+
+void resetStats() {
+  i2cBus = {};
+  spiBus = {};
+}
+
+const uint8_t *panelRam(uint8_t address) {
+  Ssd1306Panel *panel = panelAt(address);
+  return panel ? panel->ram() : NULL;
+}
+
+}  // namespace sim
@@ -0,0 +1,58 @@
+/*
+ * Project: Host Particle HAL
+ * Description: The simulation's side of the host HAL. A driver program uses
+ *              these to move the virtual clock, drive input pins (which fires
+ *              attached interrupts), read back outputs and inspect bus traffic.
+*/
+
+#ifndef _HOST_SIM_H_
+#define _HOST_SIM_H_
+
+#include "Particle.h"
+
+namespace sim {
+
+//  Virtual clock. millis()/micros() read it, delay() on the main thread
+//  advances it. Other threads sleep in real time instead.
+uint64_t nowMicros();
+void advanceMicros(uint64_t us);
+
+//  Drive an input pin from outside the device. Fires any interrupt
+//  attached to the pin whose mode matches the edge.
+void setInput(pin_t pin, bool level);
+void releaseInput(pin_t pin);
+bool outputLevel(pin_t pin);
+
+//  Times any output pin has changed level, for telling loop() passes that
+//  did something from idle ones.
+uint64_t outputChanges();
+
+//  Charge bus transfer time (I2C at the Wire clock, SPI at the SPI clock)
+//  to the virtual clock, so loop() passes take as long as they would on
+//  the device. On by default.
+void setBusTiming(bool enabled);
+
+//  Whether WiFi.ready() is true and TCPClient may open real sockets.
+//  Off by default, so network calls fail fast like an offline device.
+void setNetworkReady(bool ready);
+
+//  Echo Serial output to stdout. Off by default.
+void setSerialEcho(bool enabled);
+
+struct BusStats {
+  uint64_t transactions;
+  uint64_t bytes;
+  uint64_t busMicros;       // time the transfers would take on the wire
+};
+
+BusStats i2cStats();
+BusStats spiStats();
+void resetStats();
+
+//  GDDRAM of the simulated SSD1306 at an I2C address (0x3C or 0x3D),
+//  in the controller's native page layout. NULL for other addresses.
+const uint8_t *panelRam(uint8_t address);
+
+}  // namespace sim
+
+#endif // _HOST_SIM_H_
@@ -0,0 +1,132 @@
+/*
+ * Project: Slow Motion Showdown frame generator
+ * Description: Draws the game's fixed screens with the real Adafruit_GFX /
+ *              Adafruit_SSD1306 code and writes them out as SSD1306 page
+ *              images, for the sketch to show with displayFrame(). The
+ *              screens are defined here; rebuild the header after changing
+ *              one with the 'frames' target and commit it, since device
+ *              builds can't run this.
+ *
+ * Usage: make_frames <output header>
+*/
+
+#include "Particle.h"
+#include "Adafruit_SSD1306.h"
+
+#include <stdio.h>
+
+static const int FRAME_BYTES = SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8;
+
+static uint8_t canvas[FRAME_BYTES];
+static Adafruit_SSD1306 oled(-1, canvas);
+
+//  Start a screen the way the sketch starts drawing one
+static void blank(uint8_t size, int16_t x = 0, int16_t y = 0) {
+  oled.clearDisplay();
+  oled.setTextColor(WHITE);
+  oled.setTextSize(size);
+  oled.setCursor(x, y);
+}
+
+static void title() {
+  blank(2, 0, 10);
+  oled.printf("Slow\nMotion\nShowdown");
+}
+
+static void player(const char *name) {
+  blank(3, 10, 5);
+  oled.printf("Player");
+  oled.setCursor(10, 35);
+  oled.printf("%s", name);
+}
+
+static void player1() { player("1-Gold"); }
+static void player2() { player("2-Blue"); }
+
+static void placeHands() {
+  blank(2);
+  oled.printf("Place both");
+  oled.printf("hands on\nthe white\nbuttons");
+}
+
+static void getReady() {
+  blank(2);
+  oled.printf("Get ready\nto start\nin...");
+}
+
+static void digit(const char *text) {
+  blank(9, 40, 0);
+  oled.printf("%s", text);
+}
+
+static void count3() { digit("3"); }
+static void count2() { digit("2"); }
+static void count1() { digit("1"); }
+
+static void big(const char *text) {
+  blank(4);
+  oled.printf("%s", text);
+}
+
+static void goldLost() { big("GOLD\nLOST"); }
+static void blueLost() { big("BLUE\nLOST"); }
+static void noLoser() { big("ERROR"); }
+static void goldWins() { big("GOLD\nWINS!"); }
+static void blueWins() { big("BLUE\nWINS!"); }
+
+struct Frame {
+  const char *name;
+  void (*draw)();
+};
+
+static const Frame FRAMES[] = {
+  {"FRAME_TITLE", title},
+  {"FRAME_PLAYER1", player1},
+  {"FRAME_PLAYER2", player2},
+  {"FRAME_PLACEHANDS", placeHands},
+  {"FRAME_GETREADY", getReady},
+  {"FRAME_COUNT3", count3},
+  {"FRAME_COUNT2", count2},
+  {"FRAME_COUNT1", count1},
+  {"FRAME_GOLDLOST", goldLost},
+  {"FRAME_BLUELOST", blueLost},
+  {"FRAME_NOLOSER", noLoser},
+  {"FRAME_GOLDWINS", goldWins},
+  {"FRAME_BLUEWINS", blueWins},
+};
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: make_frames <output header>\n");
+    return 1;
+  }
+  FILE *out = fopen(argv[1], "w");
+  if (!out) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  fprintf(out,
+          "/*\n"
+          " * The fixed game screens as SSD1306 page images, for displayFrame().\n"
+          " * Generated by host/make_frames.cpp - edit the screens there and\n"
+          " * rebuild with the host build's 'frames' target.\n"
+          "*/\n"
+          "\n"
+          "#ifndef _GAMEFRAMES_H_\n"
+          "#define _GAMEFRAMES_H_\n"
+          "\n"
+          "#include \"Particle.h\"\n");
+
+  for (const Frame &frame : FRAMES) {
+    frame.draw();
+    fprintf(out, "\nconst uint8_t %s[%d] = {\n", frame.name, FRAME_BYTES);
+    for (int i = 0; i < FRAME_BYTES; i++) {
+      fprintf(out, "%s0x%02X,%s", (i % 16) ? " " : "", canvas[i], (i % 16 == 15) ? "\n" : "");
+    }
+    fprintf(out, "};\n");
+  }
+
+  fprintf(out, "\n#endif // _GAMEFRAMES_H_\n");
+  return fclose(out) == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+/*
+ * Project: Slow Motion Showdown network benchmark
+ * Description: Runs the Hue and Wemo library calls the game makes against
+ *              device_server and reports how long each takes and how many
+ *              succeed. Built with HUE_HUB_IP/WEMO_IPS pointing at the
+ *              server's loopback addresses, so start that first:
+ *
+ *                device_server -latency 20 &
+ *                network_bench 200
+ *
+ * Usage: network_bench [count] [-v]
+*/
+
+#include "Particle.h"
+#include "sim.h"
+#include "hue.h"
+#include "wemo.h"
+#include "WemoFanout.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+static const int BENCH_LIGHT = 1;
+static const int BENCH_LIGHTS[] = {1, 2, 3};
+static const int BENCH_OUTLETS[] = {0, 1, 2, 3, 4, 5};
+
+//  Time count calls of a command and print the spread. The command gets
+//  the call number and returns whether it succeeded. prepare, if given,
+//  runs untimed before each call.
+static void bench(const char *name, long count, const std::function<bool(long)> &command,
+                  const std::function<void()> &prepare = nullptr) {
+  std::vector<double> times;
+  long succeeded = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < count; i++) {
+    if (prepare) {
+      prepare();
+    }
+    auto before = std::chrono::steady_clock::now();
+    succeeded += command(i) ? 1 : 0;
+    times.push_back(std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - before).count());
+  }
+  double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (times.empty()) {
+    return;
+  }
+  std::sort(times.begin(), times.end());
+  double sum = 0;
+  for (double t : times) {
+    sum += t;
+  }
+  printf("%-20s %5ld/%-5ld ok   mean %7.2f  p50 %7.2f  p99 %7.2f  max %7.2f ms   %7.1f/s\n",
+         name, succeeded, count, sum / times.size(), times[times.size() / 2],
+         times[std::min(times.size() - 1, times.size() * 99 / 100)], times.back(),
+         count / total);
+}
+
+int main(int argc, char *argv[]) {
+  long count = 100;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-v") == 0) {
+      sim::setSerialEcho(true);
+    } else {
+      count = atol(argv[i]);
+    }
+  }
+  sim::setNetworkReady(true);
+
+  printf("Hue bridge %s:%d, Wemo outlets %s-%s:%d\n", hueHubIP, hueHubPort,
+         wemoIP[0], wemoIP[5], wemoPort);
+
+  //  Colors change every call so the state cache never skips one
+  bench("setHue", count, [](long i) {
+    return setHue(BENCH_LIGHT, true, (i * 1000) % 65536, 200, 255);
+  });
+  bench("getHue", count, [](long i) {
+    HueLightState state;
+    (void)i;
+    return getHue(BENCH_LIGHT, state) && state.has(HUE_FIELD_ON);
+  });
+
+  int group = hueGroupFor("Showdown", BENCH_LIGHTS, 3);
+  printf("hueGroupFor          group %d\n", group);
+  bench("setHueGroup", count, [group](long i) {
+    return group != 0 && setHueGroup(group, true, (i * 1000) % 65536, 200, 255);
+  });
+
+  bench("wemoWrite", count, [](long i) {
+    return wemoWrite(i % 6, i & 1);
+  });
+
+  WemoFanout fanout;
+  fanout.begin();
+  bench("WemoFanout x6", count, [&fanout](long i) {
+    return fanout.write(BENCH_OUTLETS, 6, i & 1) == 6;
+  });
+
+  //  Connections opened ahead, as during the countdown; only the write is timed
+  bench("WemoFanout x6 warm", count, [&fanout](long i) {
+    return fanout.write(BENCH_OUTLETS, 6, i & 1) == 6;
+  }, [&fanout]() {
+    fanout.warm(BENCH_OUTLETS, 6);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  });
+
+  printf("breakers open:      hue %s, wemo", hueBreaker.isOpen() ? "yes" : "no");
+  for (int i = 0; i < 6; i++) {
+    printf(" %s", wemoBreaker[i].isOpen() ? "yes" : "no");
+  }
+  printf("\n");
+  return 0;
+}
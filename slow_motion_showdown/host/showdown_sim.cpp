@@ -0,0 +1,180 @@
+/*
+ * Project: Slow Motion Showdown host simulation
+ * Description: Runs the real firmware against the host HAL. Flips the game
+ *              into auto mode, then plays rounds by driving the ready
+ *              buttons, player buttons and motion sensors, checks the scores
+ *              come out right, and reports how long loop() passes take on
+ *              the virtual clock and how much bus traffic they cost.
+ *
+ * Usage: showdown_sim [rounds] [-v]
+*/
+
+#include "Particle.h"
+#include "sim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+void setup();
+void loop();
+
+extern int p1Score;
+extern int p2Score;
+
+//  Pins as wired in slow_motion_showdown.cpp
+static const pin_t READYBUTTONPINP1 = A2;
+static const pin_t READYBUTTONPINP2 = A5;
+static const pin_t P1BUTTONPIN = A1;
+static const pin_t P2BUTTONPIN = A0;
+static const pin_t P1MOTIONPIN = D10;
+static const pin_t P2MOTIONPIN = D3;
+static const pin_t AUTOMODEPIN = D17;
+static const pin_t READYLEDPIN = D7;
+static const pin_t PLAYERLEDPIN = D19;
+
+static const uint64_t LOOP_OVERHEAD_US = 50;    //time a pass takes besides bus traffic
+static const uint64_t GIVE_UP_US = 60000000;    //virtual time to wait for an output
+static const uint64_t MAX_IDLE_STEP = 1000;     //most idle passes skipped in one step (50 ms)
+
+static uint64_t passes = 0;
+
+static void runPass() {
+  loop();
+  sim::advanceMicros(LOOP_OVERHEAD_US);
+  passes++;
+}
+
+//  Anything a pass can do that shows: bus traffic or an output changing.
+static uint64_t activity() {
+  return sim::i2cStats().transactions + sim::spiStats().transactions + sim::outputChanges();
+}
+
+//  Run loop() until the pin reads the level, or give up. Most passes only
+//  wait on one of the game's timers, so while they do nothing the clock is
+//  moved on in growing steps, each counted as the idle passes it stands
+//  for. The first pass that does something drops back to single passes.
+static bool runUntil(pin_t pin, bool level) {
+  uint64_t giveUp = sim::nowMicros() + GIVE_UP_US;
+  uint64_t idleStep = 1;
+  while (sim::nowMicros() < giveUp) {
+    if (sim::outputLevel(pin) == level) {
+      return true;
+    }
+    uint64_t before = activity();
+    runPass();
+    if (activity() != before) {
+      idleStep = 1;
+      continue;
+    }
+    sim::advanceMicros((idleStep - 1) * LOOP_OVERHEAD_US);
+    passes += idleStep - 1;
+    idleStep = std::min(idleStep * 2, MAX_IDLE_STEP);
+  }
+  return false;
+}
+
+struct Outcome {
+  pin_t pin;
+  int p1Points;
+  int p2Points;
+};
+
+static const Outcome OUTCOMES[] = {
+  {P1BUTTONPIN, 5, 0},
+  {P2BUTTONPIN, 0, 5},
+  {P1MOTIONPIN, 0, 1},
+  {P2MOTIONPIN, 1, 0},
+};
+
+int main(int argc, char *argv[]) {
+  long rounds = 1000;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-v") == 0) {
+      sim::setSerialEcho(true);
+    } else {
+      rounds = atol(argv[i]);
+    }
+  }
+
+  std::mt19937 rng(12345);
+  auto startTime = std::chrono::steady_clock::now();
+
+  setup();
+  sim::setInput(AUTOMODEPIN, HIGH);
+  if (!runUntil(READYLEDPIN, HIGH)) {
+    fprintf(stderr, "game never reached the waiting screen\n");
+    return 1;
+  }
+
+  sim::resetStats();
+  uint64_t firstPass = passes;
+  uint64_t firstMicros = sim::nowMicros();
+  long mismatches = 0;
+
+  for (long round = 0; round < rounds; round++) {
+    int p1Before = p1Score, p2Before = p2Score;
+
+    sim::setInput(READYBUTTONPINP1, HIGH);
+    sim::setInput(READYBUTTONPINP2, HIGH);
+    if (!runUntil(PLAYERLEDPIN, HIGH)) {
+      fprintf(stderr, "round %ld never started\n", round);
+      return 1;
+    }
+    sim::setInput(READYBUTTONPINP1, LOW);
+    sim::setInput(READYBUTTONPINP2, LOW);
+
+    std::uniform_int_distribution<int> passCount(0, 3);
+    for (int i = passCount(rng); i > 0; i--) {
+      runPass();
+    }
+    sim::advanceMicros(std::uniform_int_distribution<int>(0, 500000)(rng));
+
+    //  The first edge decides the round. Half the time a second input
+    //  fires a moment later, before loop() gets to look; it must lose.
+    const Outcome &first = OUTCOMES[std::uniform_int_distribution<int>(0, 3)(rng)];
+    sim::setInput(first.pin, HIGH);
+    const Outcome *second = NULL;
+    if (rng() & 1) {
+      second = &OUTCOMES[std::uniform_int_distribution<int>(0, 3)(rng)];
+      if (second->pin != first.pin) {
+        sim::advanceMicros(std::uniform_int_distribution<int>(1, 2000)(rng));
+        sim::setInput(second->pin, HIGH);
+      }
+    }
+
+    if (!runUntil(READYLEDPIN, HIGH)) {
+      fprintf(stderr, "round %ld never finished\n", round);
+      return 1;
+    }
+    sim::setInput(first.pin, LOW);
+    if (second) {
+      sim::setInput(second->pin, LOW);
+    }
+
+    if (p1Score - p1Before != first.p1Points || p2Score - p2Before != first.p2Points) {
+      mismatches++;
+    }
+  }
+
+  double realSeconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  uint64_t gamePasses = passes - firstPass;
+  double virtualSeconds = (sim::nowMicros() - firstMicros) / 1e6;
+  sim::BusStats i2c = sim::i2cStats();
+  sim::BusStats spi = sim::spiStats();
+
+  printf("rounds played       %ld (%ld scored wrong)\n", rounds, mismatches);
+  printf("real time           %.3f s (%.0f rounds/s)\n", realSeconds, rounds / realSeconds);
+  printf("virtual time        %.1f s\n", virtualSeconds);
+  printf("loop() passes       %llu (%.3f ms each)\n", (unsigned long long)gamePasses,
+         gamePasses ? virtualSeconds * 1000 / gamePasses : 0.0);
+  printf("I2C per pass        %.1f transactions, %.1f bytes, %.3f ms on the bus\n",
+         (double)i2c.transactions / gamePasses, (double)i2c.bytes / gamePasses,
+         i2c.busMicros / 1000.0 / gamePasses);
+  printf("SPI per pass        %.1f transfers, %.1f bytes, %.3f ms on the bus\n",
+         (double)spi.transactions / gamePasses, (double)spi.bytes / gamePasses,
+         spi.busMicros / 1000.0 / gamePasses);
+
+  return mismatches ? 1 : 0;
+}
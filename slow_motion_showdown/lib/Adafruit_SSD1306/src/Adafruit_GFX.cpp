@@ -636,6 +636,10 @@ size_t Adafruit_GFX::write(uint8_t c) {
   return 1;
 }
 
+const uint8_t *Adafruit_GFX::glyph(unsigned char c) {
+  return font + c * 5;
+}
+
 // Draw a character
 void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
 			    uint16_t color, uint16_t bg, uint8_t size) {
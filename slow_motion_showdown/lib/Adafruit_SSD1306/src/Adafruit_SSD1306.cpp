@@ -19,9 +19,9 @@ All text above, and the splash screen below must be included in any redistributi
 #include "Adafruit_GFX.h"
 #include "Adafruit_SSD1306.h"
 
-// the memory buffer for the LCD
+// the splash screen every new display buffer starts out with
 
-static uint8_t buffer[SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8] = { 
+static const uint8_t splash[SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8] = { 
 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -121,34 +121,59 @@ void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
 }
 
 // constructor for software SPI - we indicate DataCommand, ChipSelect, Reset 
-Adafruit_SSD1306::Adafruit_SSD1306(int8_t SID, int8_t SCLK, int8_t DC, int8_t RST, int8_t CS) : Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT) {
+Adafruit_SSD1306::Adafruit_SSD1306(int8_t SID, int8_t SCLK, int8_t DC, int8_t RST, int8_t CS, uint8_t *buf) : Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT) {
+  initBuffer(buf);
   cs = CS;
   rst = RST;
   dc = DC;
   sclk = SCLK;
   sid = SID;
   hwSPI = false;
+  sentValid = false;
 }
 
 // constructor for hardware SPI - we indicate DataCommand, ChipSelect, Reset 
-Adafruit_SSD1306::Adafruit_SSD1306(int8_t DC, int8_t RST, int8_t CS) : Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT) {
+Adafruit_SSD1306::Adafruit_SSD1306(int8_t DC, int8_t RST, int8_t CS, uint8_t *buf) : Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT) {
+  initBuffer(buf);
   dc = DC;
   rst = RST;
   cs = CS;
   hwSPI = true;
+  sentValid = false;
 }
 
 // initializer for I2C - we only indicate the reset pin!
-Adafruit_SSD1306::Adafruit_SSD1306(int8_t reset) :
+Adafruit_SSD1306::Adafruit_SSD1306(int8_t reset, uint8_t *buf) :
 Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT) {
+  initBuffer(buf);
   sclk = dc = cs = sid = -1;
   rst = reset;
+  sentValid = false;
 }
   
 
+Adafruit_SSD1306::~Adafruit_SSD1306() {
+  if (ownBuffer) {
+    free(buffer);
+  }
+}
+
+// Draw into the caller's buffer if one was given, otherwise into one of
+// our own. Either way it starts out holding the splash screen.
+void Adafruit_SSD1306::initBuffer(uint8_t *buf) {
+  ownBuffer = (buf == NULL);
+  buffer = buf ? buf : (uint8_t *)malloc(SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8);
+  memcpy(buffer, splash, sizeof(splash));
+}
+
+uint8_t *Adafruit_SSD1306::getBuffer(void) {
+  return buffer;
+}
+
 void Adafruit_SSD1306::begin(uint8_t vccstate, uint8_t i2caddr) {
   _vccstate = vccstate;
   _i2caddr = i2caddr;
+  sentValid = false;    // panel RAM is unknown until the first full display()
 
   // set pin directions
   if (sid != -1){
@@ -169,8 +194,11 @@ void Adafruit_SSD1306::begin(uint8_t vccstate, uint8_t i2caddr) {
     }
   else
   {
-    // I2C Init
-    Wire.begin();
+    // I2C Init, once for all the displays on the bus
+    if (!Wire.isEnabled()) {
+      Wire.setSpeed(SSD1306_I2C_CLOCK);
+      Wire.begin();
+    }
   }
 
   // Setup reset pin direction (used by both SPI and I2C)  
@@ -186,78 +214,40 @@ void Adafruit_SSD1306::begin(uint8_t vccstate, uint8_t i2caddr) {
   digitalWrite(rst, HIGH);
   // turn on VCC (9V?)
 
-   #if defined SSD1306_128_32
-    // Init sequence for 128x32 OLED module
-    ssd1306_command(SSD1306_DISPLAYOFF);                    // 0xAE
-    ssd1306_command(SSD1306_SETDISPLAYCLOCKDIV);            // 0xD5
-    ssd1306_command(0x80);                                  // the suggested ratio 0x80
-    ssd1306_command(SSD1306_SETMULTIPLEX);                  // 0xA8
-    ssd1306_command(0x1F);
-    ssd1306_command(SSD1306_SETDISPLAYOFFSET);              // 0xD3
-    ssd1306_command(0x0);                                   // no offset
-    ssd1306_command(SSD1306_SETSTARTLINE | 0x0);            // line #0
-    ssd1306_command(SSD1306_CHARGEPUMP);                    // 0x8D
-    if (vccstate == SSD1306_EXTERNALVCC) 
-      { ssd1306_command(0x10); }
-    else 
-      { ssd1306_command(0x14); }
-    ssd1306_command(SSD1306_MEMORYMODE);                    // 0x20
-    ssd1306_command(0x00);                                  // 0x0 act like ks0108
-	ssd1306_command(SSD1306_SEGREMAP | 0x1);
-    ssd1306_command(SSD1306_COMSCANDEC);
-    ssd1306_command(SSD1306_SETCOMPINS);                    // 0xDA
-    ssd1306_command(0x02);
-    ssd1306_command(SSD1306_SETCONTRAST);                   // 0x81
-    ssd1306_command(0x8F);
-    ssd1306_command(SSD1306_SETPRECHARGE);                  // 0xd9
-    if (vccstate == SSD1306_EXTERNALVCC) 
-      { ssd1306_command(0x22); }
-    else 
-      { ssd1306_command(0xF1); }
-    ssd1306_command(SSD1306_SETVCOMDETECT);                 // 0xDB
-    ssd1306_command(0x40);
-    ssd1306_command(SSD1306_DISPLAYALLON_RESUME);           // 0xA4
-    ssd1306_command(SSD1306_NORMALDISPLAY);                 // 0xA6
+  // The whole init sequence goes out as one command stream
+  const uint8_t init[] = {
+    SSD1306_DISPLAYOFF,                                     // 0xAE
+    SSD1306_SETDISPLAYCLOCKDIV, 0x80,                       // 0xD5, the suggested ratio 0x80
+  #if defined SSD1306_128_32
+    SSD1306_SETMULTIPLEX, 0x1F,                             // 0xA8
   #endif
-
   #if defined SSD1306_128_64
-    // Init sequence for 128x64 OLED module
-    ssd1306_command(SSD1306_DISPLAYOFF);                    // 0xAE
-    ssd1306_command(SSD1306_SETDISPLAYCLOCKDIV);            // 0xD5
-    ssd1306_command(0x80);                                  // the suggested ratio 0x80
-    ssd1306_command(SSD1306_SETMULTIPLEX);                  // 0xA8
-    ssd1306_command(0x3F);
-    ssd1306_command(SSD1306_SETDISPLAYOFFSET);              // 0xD3
-    ssd1306_command(0x0);                                   // no offset
-    ssd1306_command(SSD1306_SETSTARTLINE | 0x0);            // line #0
-    ssd1306_command(SSD1306_CHARGEPUMP);                    // 0x8D
-    if (vccstate == SSD1306_EXTERNALVCC) 
-      { ssd1306_command(0x10); }
-    else 
-      { ssd1306_command(0x14); }
-    ssd1306_command(SSD1306_MEMORYMODE);                    // 0x20
-    ssd1306_command(0x00);                                  // 0x0 act like ks0108
-    ssd1306_command(SSD1306_SEGREMAP | 0x1);
-    ssd1306_command(SSD1306_COMSCANDEC);
-    ssd1306_command(SSD1306_SETCOMPINS);                    // 0xDA
-    ssd1306_command(0x12);
-    ssd1306_command(SSD1306_SETCONTRAST);                   // 0x81
-    if (vccstate == SSD1306_EXTERNALVCC) 
-      { ssd1306_command(0x9F); }
-    else 
-      { ssd1306_command(0xCF); }
-    ssd1306_command(SSD1306_SETPRECHARGE);                  // 0xd9
-    if (vccstate == SSD1306_EXTERNALVCC) 
-      { ssd1306_command(0x22); }
-    else 
-      { ssd1306_command(0xF1); }
-    ssd1306_command(SSD1306_SETVCOMDETECT);                 // 0xDB
-    ssd1306_command(0x40);
-    ssd1306_command(SSD1306_DISPLAYALLON_RESUME);           // 0xA4
-    ssd1306_command(SSD1306_NORMALDISPLAY);                 // 0xA6
+    SSD1306_SETMULTIPLEX, 0x3F,                             // 0xA8
   #endif
-  
-  ssd1306_command(SSD1306_DISPLAYON);//--turn on oled panel
+    SSD1306_SETDISPLAYOFFSET, 0x0,                          // 0xD3, no offset
+    SSD1306_SETSTARTLINE | 0x0,                             // line #0
+    SSD1306_CHARGEPUMP,                                     // 0x8D
+    (uint8_t)((vccstate == SSD1306_EXTERNALVCC) ? 0x10 : 0x14),
+    SSD1306_MEMORYMODE, 0x00,                               // 0x20, 0x0 act like ks0108
+    SSD1306_SEGREMAP | 0x1,
+    SSD1306_COMSCANDEC,
+  #if defined SSD1306_128_32
+    SSD1306_SETCOMPINS, 0x02,                               // 0xDA
+    SSD1306_SETCONTRAST, 0x8F,                              // 0x81
+  #endif
+  #if defined SSD1306_128_64
+    SSD1306_SETCOMPINS, 0x12,                               // 0xDA
+    SSD1306_SETCONTRAST,                                    // 0x81
+    (uint8_t)((vccstate == SSD1306_EXTERNALVCC) ? 0x9F : 0xCF),
+  #endif
+    SSD1306_SETPRECHARGE,                                   // 0xd9
+    (uint8_t)((vccstate == SSD1306_EXTERNALVCC) ? 0x22 : 0xF1),
+    SSD1306_SETVCOMDETECT, 0x40,                            // 0xDB
+    SSD1306_DISPLAYALLON_RESUME,                            // 0xA4
+    SSD1306_NORMALDISPLAY,                                  // 0xA6
+    SSD1306_DISPLAYON                                       //--turn on oled panel
+  };
+  ssd1306_commandList(init, sizeof(init));
 }
 
 
@@ -290,19 +280,47 @@ void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
   }
 }
 
+// Send a run of command bytes (commands with their arguments) as one
+// stream: a single chip select over SPI, and on I2C one control byte per
+// transaction with as many commands as fit in Wire's buffer.
+void Adafruit_SSD1306::ssd1306_commandList(const uint8_t *c, uint8_t n) {
+  if (sid != -1)
+  {
+    // SPI
+    digitalWrite(cs, HIGH);
+    digitalWrite(dc, LOW);
+    digitalWrite(cs, LOW);
+    while (n--) {
+      fastSPIwrite(*c++);
+    }
+    digitalWrite(cs, HIGH);
+  }
+  else
+  {
+    // I2C
+    while (n) {
+      uint8_t batch = (n < SSD1306_COMMAND_BATCH) ? n : SSD1306_COMMAND_BATCH;
+      Wire.beginTransmission(_i2caddr);
+      Wire.write((uint8_t)0x00);  // Co = 0, D/C = 0
+      Wire.write(c, batch);
+      Wire.endTransmission();
+      c += batch;
+      n -= batch;
+    }
+  }
+}
+
 // startscrollright
 // Activate a right handed scroll for rows start through stop
 // Hint, the display is 16 rows tall. To scroll the whole display, run:
 // display.scrollright(0x00, 0x0F) 
 void Adafruit_SSD1306::startscrollright(uint8_t start, uint8_t stop){
-	ssd1306_command(SSD1306_RIGHT_HORIZONTAL_SCROLL);
-	ssd1306_command(0X00);
-	ssd1306_command(start);
-	ssd1306_command(0X00);
-	ssd1306_command(stop);
-	ssd1306_command(0X00);
-	ssd1306_command(0XFF);
-	ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+	const uint8_t scroll[] = {
+		SSD1306_RIGHT_HORIZONTAL_SCROLL, 0X00, start, 0X00, stop, 0X00, 0XFF,
+		SSD1306_ACTIVATE_SCROLL
+	};
+	ssd1306_commandList(scroll, sizeof(scroll));
+	sentValid = false;
 }
 
 // startscrollleft
@@ -310,14 +328,12 @@ void Adafruit_SSD1306::startscrollright(uint8_t start, uint8_t stop){
 // Hint, the display is 16 rows tall. To scroll the whole display, run:
 // display.scrollright(0x00, 0x0F) 
 void Adafruit_SSD1306::startscrollleft(uint8_t start, uint8_t stop){
-	ssd1306_command(SSD1306_LEFT_HORIZONTAL_SCROLL);
-	ssd1306_command(0X00);
-	ssd1306_command(start);
-	ssd1306_command(0X00);
-	ssd1306_command(stop);
-	ssd1306_command(0X00);
-	ssd1306_command(0XFF);
-	ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+	const uint8_t scroll[] = {
+		SSD1306_LEFT_HORIZONTAL_SCROLL, 0X00, start, 0X00, stop, 0X00, 0XFF,
+		SSD1306_ACTIVATE_SCROLL
+	};
+	ssd1306_commandList(scroll, sizeof(scroll));
+	sentValid = false;
 }
 
 // startscrolldiagright
@@ -325,16 +341,13 @@ void Adafruit_SSD1306::startscrollleft(uint8_t start, uint8_t stop){
 // Hint, the display is 16 rows tall. To scroll the whole display, run:
 // display.scrollright(0x00, 0x0F) 
 void Adafruit_SSD1306::startscrolldiagright(uint8_t start, uint8_t stop){
-	ssd1306_command(SSD1306_SET_VERTICAL_SCROLL_AREA);	
-	ssd1306_command(0X00);
-	ssd1306_command(SSD1306_LCDHEIGHT);
-	ssd1306_command(SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL);
-	ssd1306_command(0X00);
-	ssd1306_command(start);
-	ssd1306_command(0X00);
-	ssd1306_command(stop);
-	ssd1306_command(0X01);
-	ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+	const uint8_t scroll[] = {
+		SSD1306_SET_VERTICAL_SCROLL_AREA, 0X00, SSD1306_LCDHEIGHT,
+		SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL, 0X00, start, 0X00, stop, 0X01,
+		SSD1306_ACTIVATE_SCROLL
+	};
+	ssd1306_commandList(scroll, sizeof(scroll));
+	sentValid = false;
 }
 
 // startscrolldiagleft
@@ -342,20 +355,21 @@ void Adafruit_SSD1306::startscrolldiagright(uint8_t start, uint8_t stop){
 // Hint, the display is 16 rows tall. To scroll the whole display, run:
 // display.scrollright(0x00, 0x0F) 
 void Adafruit_SSD1306::startscrolldiagleft(uint8_t start, uint8_t stop){
-	ssd1306_command(SSD1306_SET_VERTICAL_SCROLL_AREA);	
-	ssd1306_command(0X00);
-	ssd1306_command(SSD1306_LCDHEIGHT);
-	ssd1306_command(SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL);
-	ssd1306_command(0X00);
-	ssd1306_command(start);
-	ssd1306_command(0X00);
-	ssd1306_command(stop);
-	ssd1306_command(0X01);
-	ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+	const uint8_t scroll[] = {
+		SSD1306_SET_VERTICAL_SCROLL_AREA, 0X00, SSD1306_LCDHEIGHT,
+		SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL, 0X00, start, 0X00, stop, 0X01,
+		SSD1306_ACTIVATE_SCROLL
+	};
+	ssd1306_commandList(scroll, sizeof(scroll));
+	sentValid = false;
 }
 
+// The panel's RAM has been scrolled and has to be rewritten (see the
+// datasheet's notes on DEACTIVATE_SCROLL), so the next display() sends
+// the whole frame.
 void Adafruit_SSD1306::stopscroll(void){
 	ssd1306_command(SSD1306_DEACTIVATE_SCROLL);
+	sentValid = false;
 }
 
 // Dim the display
@@ -375,8 +389,8 @@ void Adafruit_SSD1306::dim(bool dim) {
   }
   // the range of contrast to too small to be really useful
   // it is useful to dim the display
-  ssd1306_command(SSD1306_SETCONTRAST);
-  ssd1306_command(contrast);
+  const uint8_t cmds[] = { SSD1306_SETCONTRAST, contrast };
+  ssd1306_commandList(cmds, sizeof(cmds));
 }
 
 void Adafruit_SSD1306::ssd1306_data(uint8_t c) {
@@ -401,13 +415,75 @@ void Adafruit_SSD1306::ssd1306_data(uint8_t c) {
 }
 
 void Adafruit_SSD1306::display(void) {
-  ssd1306_command(SSD1306_COLUMNADDR);
-  ssd1306_command(0);   // Column start address (0 = reset)
-  ssd1306_command(127); // Column end address (127 = reset)
+  sendFrame(buffer);
+}
 
-  ssd1306_command(SSD1306_PAGEADDR);
-  ssd1306_command(0); // Page start address (0 = reset)
-  ssd1306_command((SSD1306_LCDHEIGHT == 64) ? 7 : 3); // Page end address
+// Show a complete picture in the panel's page layout (1 KB, e.g. a const
+// array in flash) without touching the framebuffer, which keeps whatever
+// was drawn in it.
+void Adafruit_SSD1306::displayFrame(const uint8_t *frame) {
+  sendFrame(frame);
+}
+
+// Only pages (and the column span within them) that differ from what was
+// last sent to the panel go out on the bus. Neighbouring dirty pages are
+// merged into one window when that is cheaper than addressing each page.
+void Adafruit_SSD1306::sendFrame(const uint8_t *frame) {
+  const uint8_t pages = SSD1306_LCDHEIGHT / 8;
+  int16_t first[pages], last[pages];
+
+  for (uint8_t page = 0; page < pages; page++) {
+    const uint8_t *row = frame + page * SSD1306_LCDWIDTH;
+    const uint8_t *old = sent + page * SSD1306_LCDWIDTH;
+    int16_t x0 = 0, x1 = SSD1306_LCDWIDTH - 1;
+
+    if (sentValid) {
+      while (x0 < SSD1306_LCDWIDTH && row[x0] == old[x0]) x0++;
+      if (x0 < SSD1306_LCDWIDTH) {
+        while (row[x1] == old[x1]) x1--;
+      }
+    }
+    first[page] = x0;
+    last[page] = x1;
+  }
+
+  uint8_t page = 0;
+  while (page < pages) {
+    if (first[page] >= SSD1306_LCDWIDTH) { page++; continue; }
+
+    uint8_t endPage = page;
+    int16_t x0 = first[page], x1 = last[page];
+    uint16_t separate = (x1 - x0 + 1) + SSD1306_WINDOW_COST;
+
+    // grow the window down while one bigger window beats separate ones
+    while (endPage + 1 < pages && first[endPage + 1] < SSD1306_LCDWIDTH) {
+      int16_t nx0 = (first[endPage + 1] < x0) ? first[endPage + 1] : x0;
+      int16_t nx1 = (last[endPage + 1] > x1) ? last[endPage + 1] : x1;
+      uint16_t merged = (endPage - page + 2) * (nx1 - nx0 + 1) + SSD1306_WINDOW_COST;
+      uint16_t apart = separate + (last[endPage + 1] - first[endPage + 1] + 1) + SSD1306_WINDOW_COST;
+      if (merged > apart) break;
+      endPage++;
+      x0 = nx0;
+      x1 = nx1;
+      separate = merged;
+    }
+
+    sendWindow(frame, page, endPage, x0, x1);
+    page = endPage + 1;
+  }
+
+  sentValid = true;
+}
+
+// Set the panel's address window and stream that rectangle of the frame.
+void Adafruit_SSD1306::sendWindow(const uint8_t *frame, uint8_t firstPage, uint8_t lastPage, uint8_t firstCol, uint8_t lastCol) {
+  const uint8_t window[] = {
+    SSD1306_COLUMNADDR, firstCol, lastCol,
+    SSD1306_PAGEADDR, firstPage, lastPage
+  };
+  ssd1306_commandList(window, sizeof(window));
+
+  uint8_t width = lastCol - firstCol + 1;
 
   if (sid != -1)
   {
@@ -417,27 +493,122 @@ void Adafruit_SSD1306::display(void) {
     digitalWrite(cs, LOW);
 	delayMicroseconds(1);		// May not be necessary - needs testing
 
-    for (uint16_t i=0; i<(SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8); i++) {
-      fastSPIwrite(buffer[i]);
-      //ssd1306_data(buffer[i]);
+    for (uint8_t page = firstPage; page <= lastPage; page++) {
+      const uint8_t *row = frame + page * SSD1306_LCDWIDTH + firstCol;
+      for (uint8_t x = 0; x < width; x++) {
+        fastSPIwrite(row[x]);
+      }
     }
 	delayMicroseconds(1);		// May not be necessary - needs testing
     digitalWrite(cs, HIGH);
   }
   else
   {
-    // I2C
-    for (uint16_t i=0; i<(SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8); i++) {
-      // send a bunch of data in one xmission
-      Wire.beginTransmission(_i2caddr);
-      Wire.write(0x40);
-      for (uint8_t x=0; x<16; x++) {
-		Wire.write(buffer[i]);
-		i++;
-		}
-	i--;
-	Wire.endTransmission();
-	}
+    // I2C: one data stream, each transaction as long as Wire's buffer
+    // allows. Wire.write() refuses a byte once the buffer is full, which
+    // ends that transaction; with a buffer from acquireWireBuffer() that
+    // holds a whole frame a full display() is a single transaction.
+    Wire.beginTransmission(_i2caddr);
+    Wire.write((uint8_t)0x40);  // Co = 0, D/C = 1
+    for (uint8_t page = firstPage; page <= lastPage; page++) {
+      const uint8_t *row = frame + page * SSD1306_LCDWIDTH + firstCol;
+      for (uint8_t x = 0; x < width; x++) {
+        if (!Wire.write(row[x])) {
+          Wire.endTransmission();
+          Wire.beginTransmission(_i2caddr);
+          Wire.write((uint8_t)0x40);
+          Wire.write(row[x]);
+        }
+      }
+    }
+    Wire.endTransmission();
+  }
+
+  for (uint8_t page = firstPage; page <= lastPage; page++) {
+    uint16_t offset = page * SSD1306_LCDWIDTH + firstCol;
+    memcpy(sent + offset, frame + offset, width);
+  }
+}
+
+// A font character scaled up: each of its 5 columns stretched to 8*size
+// bits, bit 0 at the top. Column 6 of a character cell is always blank.
+struct ScaledGlyph {
+  uint8_t c, size;
+  uint8_t columns[5][SSD1306_GLYPH_MAXSIZE];
+};
+
+static ScaledGlyph glyphCache[SSD1306_GLYPH_CACHE];
+
+// The 8 bits of a scaled column starting at bit 'offset' (may be negative),
+// 0 where they fall outside it.
+static inline uint8_t glyphBits(const uint8_t *column, int16_t bits, int16_t offset) {
+  if (offset <= -8 || offset >= bits) return 0;
+  if (offset < 0) return column[0] << -offset;
+  uint8_t shift = offset & 7, index = offset >> 3;
+  uint8_t value = column[index] >> shift;
+  if (shift && index + 1 < bits / 8) value |= column[index + 1] << (8 - shift);
+  return value;
+}
+
+// Text is most of what the game draws, at sizes where Adafruit_GFX would
+// make a fillRect() call per font bit. Unrotated text up to
+// SSD1306_GLYPH_MAXSIZE is instead written into the page bytes a column
+// at a time, from scaled glyphs built on first use.
+void Adafruit_SSD1306::drawChar(int16_t x, int16_t y, unsigned char c,
+                                uint16_t color, uint16_t bg, uint8_t size) {
+  if (getRotation() != 0 || size == 0 || size > SSD1306_GLYPH_MAXSIZE) {
+    Adafruit_GFX::drawChar(x, y, c, color, bg, size);
+    return;
+  }
+  if ((x >= WIDTH) || (y >= HEIGHT) || (x + 6 * size - 1 < 0) || (y + 8 * size - 1 < 0))
+    return;
+
+  ScaledGlyph &scaled = glyphCache[(c * 7 + size) % SSD1306_GLYPH_CACHE];
+  if (scaled.c != c || scaled.size != size) {
+    const uint8_t *font = glyph(c);
+    memset(scaled.columns, 0, sizeof(scaled.columns));
+    for (uint8_t i = 0; i < 5; i++) {
+      for (uint8_t j = 0; j < 8; j++) {
+        if (font[i] & (1 << j)) {
+          for (uint8_t k = j * size; k < (j + 1) * size; k++) {
+            scaled.columns[i][k >> 3] |= 1 << (k & 7);
+          }
+        }
+      }
+    }
+    scaled.c = c;
+    scaled.size = size;
+  }
+
+  const int16_t bits = 8 * size;
+  const boolean opaque = (bg != color);
+  int16_t firstPage = (y < 0) ? 0 : y / 8;
+  int16_t lastPage = (y + bits - 1) / 8;
+  if (lastPage >= HEIGHT / 8) lastPage = HEIGHT / 8 - 1;
+
+  for (int16_t page = firstPage; page <= lastPage; page++) {
+    int16_t offset = page * 8 - y;           // glyph bit at the top of this page
+    int16_t low = (offset < 0) ? -offset : 0;
+    int16_t high = (bits - offset < 8) ? bits - offset : 8;
+    uint8_t cover = (uint8_t)((0xFF << low) & (0xFF >> (8 - high)));
+    uint8_t *row = buffer + page * SSD1306_LCDWIDTH;
+
+    for (uint8_t i = 0; i < 6; i++) {
+      uint8_t ink = (i < 5) ? glyphBits(scaled.columns[i], bits, offset) & cover : 0;
+      uint8_t set = 0, clear = 0;
+      if (color == WHITE) set |= ink; else clear |= ink;
+      if (opaque) {
+        if (bg == WHITE) set |= cover & ~ink; else clear |= cover & ~ink;
+      }
+      if (!(set | clear)) continue;
+
+      int16_t x0 = x + i * size, x1 = x0 + size;
+      if (x0 < 0) x0 = 0;
+      if (x1 > WIDTH) x1 = WIDTH;
+      for (int16_t col = x0; col < x1; col++) {
+        row[col] = (row[col] & ~clear) | set;
+      }
+    }
   }
 }
 
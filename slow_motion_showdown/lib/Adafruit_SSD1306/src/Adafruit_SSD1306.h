@@ -87,6 +87,27 @@ All text above, and the splash screen must be included in any redistribution
 #define SSD1306_COLUMNADDR 0x21
 #define SSD1306_PAGEADDR   0x22
 
+// Rough bus cost of addressing a display() window, in data bytes: the
+// address command transaction plus the start of another data one.
+// Used to decide when neighbouring dirty pages share one window.
+#define SSD1306_WINDOW_COST 10
+
+// I2C bus clock set by begin(). The SSD1306 is rated for 400 kHz; define
+// it as 1000000 in the build for Fast-mode Plus where the MCU and panel
+// wiring manage it.
+#ifndef SSD1306_I2C_CLOCK
+  #define SSD1306_I2C_CLOCK CLOCK_SPEED_400KHZ
+#endif
+
+// Command bytes sent per I2C transaction by ssd1306_commandList(); with
+// the control byte this fills Wire's 32 byte buffer.
+#define SSD1306_COMMAND_BATCH 31
+
+// Text sizes drawChar() renders straight into page memory, and how many
+// scaled glyphs it keeps. Bigger sizes go through Adafruit_GFX.
+#define SSD1306_GLYPH_MAXSIZE 9
+#define SSD1306_GLYPH_CACHE 16
+
 #define SSD1306_COMSCANINC 0xC0
 #define SSD1306_COMSCANDEC 0xC8
 
@@ -108,17 +129,28 @@ All text above, and the splash screen must be included in any redistribution
 
 class Adafruit_SSD1306 : public Adafruit_GFX {
  public:
-  Adafruit_SSD1306(int8_t SID, int8_t SCLK, int8_t DC, int8_t RST, int8_t CS);
-  Adafruit_SSD1306(int8_t DC, int8_t RST, int8_t CS);
-  Adafruit_SSD1306(int8_t RST);
+  // Each display draws into its own framebuffer, allocated on the heap.
+  // Pass 'buf' (at least SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8 bytes)
+  // to supply the storage instead, e.g. to have two displays share one
+  // picture; then none is allocated.
+  Adafruit_SSD1306(int8_t SID, int8_t SCLK, int8_t DC, int8_t RST, int8_t CS, uint8_t *buf = NULL);
+  Adafruit_SSD1306(int8_t DC, int8_t RST, int8_t CS, uint8_t *buf = NULL);
+  Adafruit_SSD1306(int8_t RST, uint8_t *buf = NULL);
+  ~Adafruit_SSD1306();
+
+  Adafruit_SSD1306(const Adafruit_SSD1306 &) = delete;
+  Adafruit_SSD1306 &operator=(const Adafruit_SSD1306 &) = delete;
 
   void begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t i2caddr = SSD1306_I2C_ADDRESS);
   void ssd1306_command(uint8_t c);
+  void ssd1306_commandList(const uint8_t *c, uint8_t n);
   void ssd1306_data(uint8_t c);
 
+  uint8_t *getBuffer(void);
   void clearDisplay(void);
   void invertDisplay(uint8_t i);
   void display();
+  void displayFrame(const uint8_t *frame);
 
   void startscrollright(uint8_t start, uint8_t stop);
   void startscrollleft(uint8_t start, uint8_t stop);
@@ -133,6 +165,8 @@ class Adafruit_SSD1306 : public Adafruit_GFX {
 
   virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
   virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  virtual void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
+    uint16_t bg, uint8_t size);
 
  private:
   int8_t _i2caddr, _vccstate, sid, sclk, dc, rst, cs;
@@ -140,6 +174,17 @@ class Adafruit_SSD1306 : public Adafruit_GFX {
 
   boolean hwSPI;
 
+  uint8_t *buffer;
+  boolean ownBuffer;      // buffer was allocated here, not passed in
+  void initBuffer(uint8_t *buf);
+
+  // what the panel's RAM holds, so display() can skip unchanged bytes;
+  // cleared by anything that changes that RAM another way (scrolling)
+  uint8_t sent[SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8];
+  boolean sentValid;
+  void sendFrame(const uint8_t *frame);
+  void sendWindow(const uint8_t *frame, uint8_t firstPage, uint8_t lastPage, uint8_t firstCol, uint8_t lastCol);
+
   inline void drawFastVLineInternal(int16_t x, int16_t y, int16_t h, uint16_t color) __attribute__((always_inline));
   inline void drawFastHLineInternal(int16_t x, int16_t y, int16_t w, uint16_t color) __attribute__((always_inline));
 
@@ -0,0 +1,80 @@
+#ifndef _CIRCUITBREAKER_H_
+#define _CIRCUITBREAKER_H_
+
+/*
+ *  Project: IoT Classroom Library
+ *  Description: Stops calling a device that has stopped answering. After
+ *               a run of failures the breaker opens and requests fail at
+ *               once, without a connect attempt. Once the retry time has
+ *               passed, one request is let through as a probe: if it
+ *               succeeds the breaker closes, if not it stays open for
+ *               another retry time.
+ */
+
+#include "application.h"
+
+/* Usage:
+ * CircuitBreaker breaker;                // or breaker(failures, retryMs)
+ * if(!breaker.allow()) { return false; } // device is out, don't wait on it
+ * ok = talkToDevice();
+ * breaker.record(ok);
+ *
+ * Use each breaker from one thread at a time.
+ */
+
+const int CIRCUITBREAKER_FAILURES = 3;      // failures in a row that open the breaker
+const int CIRCUITBREAKER_RETRYMS = 10000;   // ms before an open breaker lets a probe through
+
+class CircuitBreaker {
+
+  int _failures;
+  int _threshold;
+  system_tick_t _retryMs;
+  system_tick_t _openedAt;
+  bool _open;
+  bool _probing;      // the one request allowed through while open is in flight
+
+  public:
+    CircuitBreaker(int failures=CIRCUITBREAKER_FAILURES, unsigned int retryMs=CIRCUITBREAKER_RETRYMS) {
+      _threshold = failures;
+      _retryMs = retryMs;
+      _failures = 0;
+      _openedAt = 0;
+      _open = false;
+      _probing = false;
+    }
+
+    // True if a request may go to the device now
+    bool allow() {
+      if(!_open) {
+        return true;
+      }
+      if(_probing || (millis() - _openedAt) < _retryMs) {
+        return false;
+      }
+      _probing = true;
+      return true;
+    }
+
+    // Report how an allowed request went
+    void record(bool success) {
+      _probing = false;
+      if(success) {
+        _failures = 0;
+        _open = false;
+        return;
+      }
+      _failures++;
+      if(_open || _failures >= _threshold) {
+        _open = true;
+        _openedAt = millis();
+      }
+    }
+
+    // True while requests are being turned away
+    bool isOpen() {
+      return _open;
+    }
+};
+
+#endif // _CIRCUITBREAKER_H_
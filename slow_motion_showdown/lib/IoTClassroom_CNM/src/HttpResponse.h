@@ -0,0 +1,167 @@
+#ifndef _HTTPRESPONSE_H_
+#define _HTTPRESPONSE_H_
+
+/*
+ *  Project: IoT Classroom Library
+ *  Description: Reads one HTTP/1.1 response off a TCPClient with no heap
+ *               use: status line, headers, then exactly Content-Length
+ *               bytes of body. Every read shares one time budget, so a
+ *               request costs a round trip, never a stream timeout.
+ */
+
+#include "application.h"
+
+/* Usage:
+ * HttpResponse response(client, 1000);  // start the clock, then send
+ * client.write(request, length);
+ * char body[128];
+ * if(response.read(body, sizeof(body)) && response.status == 200) { ... }
+ *
+ * Or response.readHeaders() followed by response.readBody() in chunks to
+ * handle a body as it arrives. After a complete response the connection
+ * can carry the next request unless response.closing is set.
+ */
+
+const int HTTPRESPONSE_LINE = 128;      // longest header line kept; longer ones are cut
+
+class HttpResponse {
+
+  TCPClient &_client;
+  system_tick_t _start;
+  system_tick_t _budget;
+  bool _headersDone;
+
+  // Next byte of the response, or -1 if the connection closed or the
+  // time budget ran out first.
+  int nextByte() {
+    while(!_client.available()) {
+      if(!_client.connected()) {
+        return -1;
+      }
+      if((millis() - _start) >= _budget) {
+        timedOut = true;
+        return -1;
+      }
+      delay(1);
+    }
+    return _client.read();
+  }
+
+  public:
+    int status;           // HTTP status code, 0 until the status line is read
+    int contentLength;    // body bytes still to read, -1 if the body runs until close
+    bool closing;         // the server will close the connection after this response
+    bool timedOut;        // the time budget ran out before the response was complete
+
+    HttpResponse(TCPClient &client, unsigned int budgetMs) : _client(client) {
+      _start = millis();
+      _budget = budgetMs;
+      _headersDone = false;
+      status = 0;
+      contentLength = -1;
+      closing = false;
+      timedOut = false;
+    }
+
+    // Read the status line and headers. False if they didn't all arrive.
+    bool readHeaders() {
+      char line[HTTPRESPONSE_LINE];
+      bool statusLine = true;
+
+      while(!_headersDone) {
+        size_t n = 0;
+        int c;
+        while((c = nextByte()) >= 0 && c != '\n') {
+          if(n < sizeof(line) - 1) {
+            line[n++] = (char)c;
+          }
+        }
+        if(c < 0) {
+          return false;
+        }
+        if(n > 0 && line[n - 1] == '\r') {
+          n--;
+        }
+        line[n] = '\0';
+
+        if(statusLine) {
+          statusLine = false;
+          const char *code = strchr(line, ' ');
+          status = code ? atoi(code + 1) : 0;
+        }
+        else if(n == 0) {
+          _headersDone = true;   // blank line ends the headers
+        }
+        else if(strncasecmp(line, "Content-Length:", 15) == 0) {
+          contentLength = atoi(line + 15);
+        }
+        else if(strncasecmp(line, "Connection:", 11) == 0 && strstr(line + 11, "close")) {
+          closing = true;
+        }
+      }
+      if(contentLength < 0) {
+        closing = true;   // body runs until close, the connection can't be reused
+      }
+      return true;
+    }
+
+    // Read the next part of the body into buffer. Returns the byte count,
+    // 0 once the body is complete, or -1 if it was cut short.
+    int readBody(char *buffer, size_t size) {
+      if(!_headersDone && !readHeaders()) {
+        return -1;
+      }
+      if(contentLength == 0 || size == 0) {
+        return 0;
+      }
+      size_t want = size;
+      if(contentLength > 0 && (size_t)contentLength < want) {
+        want = contentLength;
+      }
+      size_t n = 0;
+      int c;
+      while(n < want && (n == 0 || _client.available())) {
+        if((c = nextByte()) < 0) {
+          break;
+        }
+        buffer[n++] = (char)c;
+      }
+      if(n == 0) {
+        if(contentLength > 0 || timedOut) {
+          return -1;
+        }
+        return 0;   // no length given, the server closed at the end
+      }
+      if(contentLength > 0) {
+        contentLength -= n;
+      }
+      return n;
+    }
+
+    // Read the whole response. Keeps as much of the body as fits in body
+    // (NUL-terminated, if body is given) and discards the rest.
+    bool read(char *body = NULL, size_t size = 0) {
+      char discard[32];
+      size_t kept = 0;
+      int n;
+
+      if(!readHeaders()) {
+        return false;
+      }
+      do {
+        if(body && kept + 1 < size) {
+          n = readBody(body + kept, size - 1 - kept);
+          kept += (n > 0) ? n : 0;
+        }
+        else {
+          n = readBody(discard, sizeof(discard));
+        }
+      } while(n > 0);
+      if(body && size > 0) {
+        body[kept] = '\0';
+      }
+      return n == 0;
+    }
+};
+
+#endif // _HTTPRESPONSE_H_
@@ -0,0 +1,333 @@
+#ifndef _HUEJSON_H_
+#define _HUEJSON_H_
+
+/*
+ *  Project: Hue IoT Library
+ *  Description: Pulls what we need out of Hue bridge replies as the bytes
+ *               arrive, in fixed memory. Feed a parser the body in chunks
+ *               of any size. HueStateParser fills a HueLightState from the
+ *               "state" object of a light (or the "action" object of a
+ *               group) and skips everything else; HueGroupFinder finds a
+ *               group's id; HueErrorFinder spots a command the bridge
+ *               refused.
+ *
+ *  Plain C++ with no Device OS calls, so it builds anywhere for testing.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Usage:
+ * HueStateParser parser;
+ * while((n = response.readBody(chunk, sizeof(chunk))) > 0) {
+ *   parser.feed(chunk, n);
+ * }
+ * if(parser.state.has(HUE_FIELD_ON)) { ... parser.state.on ... }
+ */
+
+// Bits of HueLightState::fields, set for each field the reply contained
+const uint8_t HUE_FIELD_ON = 0x01;
+const uint8_t HUE_FIELD_BRI = 0x02;
+const uint8_t HUE_FIELD_HUE = 0x04;
+const uint8_t HUE_FIELD_SAT = 0x08;
+const uint8_t HUE_FIELD_CT = 0x10;
+const uint8_t HUE_FIELD_REACHABLE = 0x20;
+const uint8_t HUE_FIELD_COLORMODE = 0x40;
+
+struct HueLightState {
+  bool on;
+  int bri;              // 1-254
+  long hue;             // 0-65535
+  int sat;              // 0-254
+  int ct;               // color temperature in mireds
+  bool reachable;
+  char colormode[3];    // "hs", "xy" or "ct"
+  uint8_t fields;       // HUE_FIELD_* bits for the fields above that were read
+
+  bool has(uint8_t field) const { return (fields & field) == field; }
+};
+
+// Walks a JSON reply a byte at a time in fixed memory and reports each
+// complete value, with its key and nesting depth, to the subclass.
+class HueJsonTokenizer {
+
+  static const int MAXDEPTH = 32; // nesting tracked for object/array; deeper is skipped
+
+  uint32_t _objects;      // bit n set if nesting level n+1 is an object
+  bool _inString, _escape, _isKey, _expectKey, _inScalar;
+  int _tokenLength;
+
+  bool inObject() const {
+    return _depth > 0 && _depth <= MAXDEPTH && (_objects & (1UL << (_depth - 1)));
+  }
+
+  void append(char c) {
+    if(_tokenLength < TOKEN - 1) {
+      _token[_tokenLength++] = c;
+    }
+  }
+
+  void push(bool object) {
+    if(_depth < MAXDEPTH) {
+      if(object) {
+        _objects |= (1UL << _depth);
+      }
+      else {
+        _objects &= ~(1UL << _depth);
+      }
+    }
+    _depth++;
+  }
+
+  void endValue(bool isString) {
+    _token[_tokenLength] = '\0';
+    onValue(isString);
+  }
+
+  protected:
+    static const int TOKEN = 16;  // longest key or value kept; longer ones are cut
+
+    int _depth;             // 1 inside the outermost object or array
+    char _topKey[TOKEN];    // last key seen at depth 1
+    char _key[TOKEN];       // key of the value being read
+    char _token[TOKEN];     // the value, NUL-terminated
+
+    // A complete string or scalar value was read for _key at _depth
+    virtual void onValue(bool isString) = 0;
+    // An object was opened for _key; _depth is already the new depth
+    virtual void onObject() {}
+    // The object or array at _depth is about to close
+    virtual void onClose() {}
+
+  public:
+    HueJsonTokenizer() {
+      reset();
+    }
+    virtual ~HueJsonTokenizer() {}
+
+    // Start over for a new reply
+    virtual void reset() {
+      _objects = 0;
+      _depth = 0;
+      _inString = _escape = _isKey = _expectKey = _inScalar = false;
+      _topKey[0] = '\0';
+      _key[0] = '\0';
+      _tokenLength = 0;
+    }
+
+    void feed(const char *data, size_t length) {
+      for(size_t i = 0; i < length; i++) {
+        feed(data[i]);
+      }
+    }
+
+    void feed(char c) {
+      if(_inString) {
+        if(_escape) {
+          _escape = false;
+          append(c);
+        }
+        else if(c == '\\') {
+          _escape = true;
+        }
+        else if(c == '"') {
+          _inString = false;
+          if(_isKey) {
+            _token[_tokenLength] = '\0';
+            memcpy(_key, _token, _tokenLength + 1);
+            if(_depth == 1) {
+              memcpy(_topKey, _token, _tokenLength + 1);
+            }
+          }
+          else {
+            endValue(true);
+          }
+        }
+        else {
+          append(c);
+        }
+        return;
+      }
+
+      if(_inScalar) {
+        if(c != ',' && c != '}' && c != ']' && c != ':' && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+          append(c);
+          return;
+        }
+        _inScalar = false;
+        endValue(false);
+      }
+
+      switch(c) {
+        case '"':
+          _inString = true;
+          _isKey = _expectKey && inObject();
+          _tokenLength = 0;
+          break;
+        case '{':
+          push(true);
+          onObject();
+          _expectKey = true;
+          break;
+        case '[':
+          push(false);
+          _expectKey = false;
+          break;
+        case '}':
+        case ']':
+          onClose();
+          if(_depth > 0) {
+            _depth--;
+          }
+          _expectKey = false;
+          break;
+        case ':':
+          _expectKey = false;
+          break;
+        case ',':
+          _expectKey = inObject();
+          break;
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+          break;
+        default:
+          _inScalar = true;
+          _tokenLength = 0;
+          append(c);
+          break;
+      }
+    }
+};
+
+// Fills a HueLightState from a light's "state" or a group's "action"
+class HueStateParser : public HueJsonTokenizer {
+
+  int _stateDepth;        // depth of the state/action object, 0 when outside it
+
+  protected:
+    void onObject() {
+      if(_stateDepth == 0 && _depth == 2 && (strcmp(_key, "state") == 0 || strcmp(_key, "action") == 0)) {
+        _stateDepth = _depth;
+      }
+    }
+
+    void onClose() {
+      if(_depth == _stateDepth) {
+        _stateDepth = 0;
+      }
+    }
+
+    void onValue(bool isString) {
+      if(_stateDepth == 0 || _depth != _stateDepth) {
+        return;
+      }
+      if(isString) {
+        if(strcmp(_key, "colormode") == 0) {
+          strncpy(state.colormode, _token, sizeof(state.colormode) - 1);
+          state.colormode[sizeof(state.colormode) - 1] = '\0';
+          state.fields |= HUE_FIELD_COLORMODE;
+        }
+        return;
+      }
+      if(strcmp(_key, "on") == 0) {
+        state.on = (strcmp(_token, "true") == 0);
+        state.fields |= HUE_FIELD_ON;
+      }
+      else if(strcmp(_key, "reachable") == 0) {
+        state.reachable = (strcmp(_token, "true") == 0);
+        state.fields |= HUE_FIELD_REACHABLE;
+      }
+      else if(strcmp(_key, "bri") == 0) {
+        state.bri = atoi(_token);
+        state.fields |= HUE_FIELD_BRI;
+      }
+      else if(strcmp(_key, "hue") == 0) {
+        state.hue = atol(_token);
+        state.fields |= HUE_FIELD_HUE;
+      }
+      else if(strcmp(_key, "sat") == 0) {
+        state.sat = atoi(_token);
+        state.fields |= HUE_FIELD_SAT;
+      }
+      else if(strcmp(_key, "ct") == 0) {
+        state.ct = atoi(_token);
+        state.fields |= HUE_FIELD_CT;
+      }
+    }
+
+  public:
+    HueLightState state;
+
+    HueStateParser() {
+      reset();
+    }
+
+    void reset() {
+      HueJsonTokenizer::reset();
+      memset(&state, 0, sizeof(state));
+      _stateDepth = 0;
+    }
+};
+
+// Finds a group id: by name in a GET /groups reply ({"3":{"name":...}}),
+// or the new id in a POST /groups reply ([{"success":{"id":"3"}}]).
+class HueGroupFinder : public HueJsonTokenizer {
+
+  const char *_name;
+
+  protected:
+    void onValue(bool isString) {
+      if(!isString || id != 0) {
+        return;
+      }
+      if(_depth == 2 && _name && strcmp(_key, "name") == 0 && strncmp(_token, _name, TOKEN - 1) == 0) {
+        id = atoi(_topKey);
+      }
+      else if(strcmp(_key, "id") == 0) {
+        id = atoi(_token);
+      }
+    }
+
+  public:
+    int id;     // 0 until found
+
+    HueGroupFinder(const char *name = NULL) : _name(name) {
+      reset();
+    }
+
+    void reset() {
+      HueJsonTokenizer::reset();
+      id = 0;
+    }
+};
+
+// Spots an error in a command reply. The bridge answers 200 OK either
+// way, with one entry per change: [{"success":{...}},{"error":{...}}].
+class HueErrorFinder : public HueJsonTokenizer {
+
+  protected:
+    void onObject() {
+      if(_depth == 3 && strcmp(_key, "error") == 0) {
+        error = true;
+      }
+    }
+
+    void onValue(bool isString) {}
+
+  public:
+    bool error;
+
+    HueErrorFinder() {
+      reset();
+    }
+
+    void reset() {
+      HueJsonTokenizer::reset();
+      error = false;
+    }
+};
+
+#endif // _HUEJSON_H_
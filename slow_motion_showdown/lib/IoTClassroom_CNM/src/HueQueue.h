@@ -0,0 +1,183 @@
+#ifndef _HUEQUEUE_H_
+#define _HUEQUEUE_H_
+
+/*
+ *  Project: Hue IoT Library
+ *  Description: Sends Hue commands from a worker thread so the caller never
+ *               waits on the bridge. Each light keeps only its latest
+ *               requested state; a newer request replaces one still waiting.
+ *               Commands are paced by a token bucket to stay under the
+ *               bridge's limits (about 10 light commands or 1 group
+ *               command a second), so bursts are merged and delayed
+ *               instead of dropped by the bridge.
+ */
+
+#include "application.h"
+#include "hue.h"
+#include "TokenBucket.h"
+
+/* Usage:
+ * HueQueue hueQueue;
+ * hueQueue.begin();                 // in setup(), starts the worker thread
+ * hueQueue.setHue(lightNum, HueOn, HueColor, HueBright, HueSat);
+ * hueQueue.setHueGroup(groupNum, HueOn, HueColor, HueBright, HueSat);
+ * hueQueue.warm();                  // open the bridge connection ahead of time
+ *
+ * These take the same arguments as the functions in hue.h and return
+ * right away. Requires SYSTEM_THREAD(ENABLED).
+ *
+ * HueQueue hueQueue(perSecond, burst) sets the pacing; a light command
+ * costs 1 token and a group command HUEQUEUE_GROUPCOST.
+ */
+
+const int HUEQUEUE_MAXLIGHTS = 8;       // lights with a request in flight at once
+const int HUEQUEUE_IDLEMS = 10;         // worker poll interval when idle
+const int HUEQUEUE_RATE = 10;           // tokens a second, one per light command
+const int HUEQUEUE_BURST = 20;          // tokens that can be spent at once
+const int HUEQUEUE_GROUPCOST = 10;      // tokens a group command costs
+
+class HueQueue {
+
+  struct Request {
+    int lightNum;
+    bool group;         // lightNum is a group number (0 is all lights)
+    bool used;          // slot belongs to this light or group
+    bool pending;
+    bool on;
+    int color, bright, sat;
+  };
+
+  Request _requests[HUEQUEUE_MAXLIGHTS];
+  int _next;
+  Mutex _lock;
+  Thread *_worker;
+  TokenBucket _bucket;    // used by the worker only
+  bool _warm;             // open the connection when there's nothing to send
+
+  static os_thread_return_t run(void *param) {
+    HueQueue *queue = (HueQueue *)param;
+    while(true) {
+      Request request;
+      unsigned int waitMs = HUEQUEUE_IDLEMS;
+      if(queue->take(request, waitMs)) {
+        if(request.group) {
+          ::setHueGroup(request.lightNum, request.on, request.color, request.bright, request.sat);
+        }
+        else {
+          ::setHue(request.lightNum, request.on, request.color, request.bright, request.sat);
+        }
+      }
+      else if(queue->takeWarm()) {
+        hueWarm();
+      }
+      else {
+        delay(waitMs < HUEQUEUE_IDLEMS ? waitMs : HUEQUEUE_IDLEMS);
+      }
+    }
+  }
+
+  // Pull the next waiting request, taking lights in turn so a light that
+  // changes every pass can't starve the others. If the bucket can't pay
+  // for it yet the request stays queued, where newer states replace it,
+  // and waitMs says how long until it can.
+  bool take(Request &request, unsigned int &waitMs) {
+    bool found = false;
+    _lock.lock();
+    for(int i = 0; i < HUEQUEUE_MAXLIGHTS; i++) {
+      Request &slot = _requests[(_next + i) % HUEQUEUE_MAXLIGHTS];
+      if(slot.pending) {
+        int cost = slot.group ? HUEQUEUE_GROUPCOST : 1;
+        if(_bucket.take(cost)) {
+          request = slot;
+          slot.pending = false;
+          _next = (_next + i + 1) % HUEQUEUE_MAXLIGHTS;
+          found = true;
+        }
+        else {
+          waitMs = _bucket.waitMs(cost);
+        }
+        break;
+      }
+    }
+    _lock.unlock();
+    return found;
+  }
+
+  bool takeWarm() {
+    bool warm;
+    _lock.lock();
+    warm = _warm;
+    _warm = false;
+    _lock.unlock();
+    return warm;
+  }
+
+  // Store the latest state for a light or group in its slot
+  bool request(int lightNum, bool group, bool HueOn, int HueColor, int HueBright, int HueSat) {
+    int slot = -1;
+    _lock.lock();
+    for(int i = 0; i < HUEQUEUE_MAXLIGHTS; i++) {
+      if(_requests[i].lightNum == lightNum && _requests[i].group == group && _requests[i].used) {
+        slot = i;
+        break;
+      }
+      if(slot < 0 && !_requests[i].used) {
+        slot = i;
+      }
+    }
+    if(slot >= 0) {
+      _requests[slot].lightNum = lightNum;
+      _requests[slot].group = group;
+      _requests[slot].used = true;
+      _requests[slot].on = HueOn;
+      _requests[slot].color = HueColor;
+      _requests[slot].bright = HueBright;
+      _requests[slot].sat = HueSat;
+      _requests[slot].pending = true;
+    }
+    _lock.unlock();
+    return slot >= 0;
+  }
+
+  public:
+    HueQueue(unsigned int perSecond=HUEQUEUE_RATE, unsigned int burst=HUEQUEUE_BURST) :
+      _requests(), _next(0), _worker(NULL), _bucket(perSecond, burst), _warm(false) {}
+
+    void begin() {
+      if(_worker == NULL) {
+        _worker = new Thread("hue", run, this);
+      }
+    }
+
+    // Queue a light's new state. Replaces any state still waiting for that
+    // light. Returns false only if every slot is taken by other lights.
+    bool setHue(int lightNum, bool HueOn, int HueColor=HueBlue, int HueBright=255, int HueSat=255) {
+      return request(lightNum, false, HueOn, HueColor, HueBright, HueSat);
+    }
+
+    // Queue a group's new state, the same way
+    bool setHueGroup(int groupNum, bool HueOn, int HueColor=HueBlue, int HueBright=255, int HueSat=255) {
+      return request(groupNum, true, HueOn, HueColor, HueBright, HueSat);
+    }
+
+    // Have the worker open the bridge connection, if it isn't open, so
+    // the next command goes out on it. Returns right away.
+    void warm() {
+      _lock.lock();
+      _warm = true;
+      _lock.unlock();
+    }
+
+    // True while requests are waiting to be sent
+    bool busy() {
+      bool waiting = false;
+      _lock.lock();
+      for(int i = 0; i < HUEQUEUE_MAXLIGHTS; i++) {
+        waiting = waiting || _requests[i].pending;
+      }
+      _lock.unlock();
+      return waiting;
+    }
+};
+
+#endif // _HUEQUEUE_H_
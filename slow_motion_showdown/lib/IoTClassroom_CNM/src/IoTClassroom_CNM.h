@@ -1,5 +1,7 @@
 #include "Particle.h"
 #include "hue.h"
+#include "HueQueue.h"
 #include "wemo.h"
+#include "WemoFanout.h"
 #include "IoTTimer.h"
 #include "Button.h"
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef _TOKENBUCKET_H_
+#define _TOKENBUCKET_H_
+
+/*
+ *  Project: IoT Classroom Library
+ *  Description: Paces requests to a device that throttles. The bucket
+ *               fills at a steady rate up to a burst size, and each
+ *               request spends tokens from it, so short bursts go out at
+ *               once and longer runs settle to the steady rate.
+ */
+
+#include "application.h"
+
+/* Usage:
+ * TokenBucket bucket(10, 20);          // 10 tokens a second, bursts of 20
+ * if(bucket.take(cost)) { send(); }
+ * else { delay(bucket.waitMs(cost)); }
+ *
+ * Use each bucket from one thread at a time.
+ */
+
+class TokenBucket {
+
+  uint32_t _milliTokens;    // tokens on hand, in thousandths
+  uint32_t _capacity;       // burst size, in thousandths
+  uint32_t _rate;           // tokens added a second
+  system_tick_t _filledAt;
+
+  void refill() {
+    system_tick_t now = millis();
+    uint32_t elapsed = now - _filledAt;
+    _filledAt = now;
+    if(elapsed >= _capacity / _rate) {
+      _milliTokens = _capacity;   // long idle, and keeps the product below from overflowing
+    }
+    else if(_milliTokens + elapsed * _rate < _capacity) {
+      _milliTokens += elapsed * _rate;
+    }
+    else {
+      _milliTokens = _capacity;
+    }
+  }
+
+  public:
+    TokenBucket(unsigned int perSecond, unsigned int burst) {
+      _rate = perSecond > 0 ? perSecond : 1;
+      _capacity = burst * 1000;
+      _milliTokens = _capacity;
+      _filledAt = millis();
+    }
+
+    // Spend tokens if there are enough. False leaves the bucket as it was.
+    bool take(unsigned int tokens=1) {
+      refill();
+      if(_milliTokens < tokens * 1000) {
+        return false;
+      }
+      _milliTokens -= tokens * 1000;
+      return true;
+    }
+
+    // Milliseconds until take(tokens) would succeed
+    unsigned int waitMs(unsigned int tokens=1) {
+      refill();
+      uint32_t needed = tokens * 1000;
+      if(_milliTokens >= needed) {
+        return 0;
+      }
+      return (needed - _milliTokens + _rate - 1) / _rate;
+    }
+};
+
+#endif // _TOKENBUCKET_H_
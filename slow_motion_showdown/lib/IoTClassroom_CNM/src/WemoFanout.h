@@ -0,0 +1,187 @@
+#ifndef _WEMOFANOUT_H_
+#define _WEMOFANOUT_H_
+
+/*
+ *  Project: Wemo IoT Library
+ *  Description: Switches several Wemo outlets at once. Each outlet slot has
+ *               its own worker thread and connection, so the requests go
+ *               out in parallel and a batch costs about one outlet's round
+ *               trip. The caller waits for all of them under one deadline.
+ */
+
+#include "application.h"
+#include "wemo.h"
+
+/* Usage:
+ * WemoFanout wemoFanout;
+ * wemoFanout.begin();                          // in setup(), starts the workers
+ * wemoFanout.write(outlets, count, wemoState); // returns outlets acknowledged
+ * wemoFanout.warm(outlets, count);             // connect now, write later
+ *
+ * Requires SYSTEM_THREAD(ENABLED).
+ */
+
+const int WEMOFANOUT_MAX = 6;           // outlets switched in one batch
+const int WEMOFANOUT_DEADLINE = 1500;   // ms a batch may take
+
+class WemoFanout {
+
+  struct Worker {
+    TCPClient client;
+    int outlet;
+    bool state;
+    bool acknowledged;
+    bool warm;                // the job is to open the connection, not to write
+    int warmOutlet;           // outlet the client was opened to, -1 if none
+    bool busy;                // a job is running
+    bool queued;              // a write to run once the current job is over
+    int queuedOutlet;
+    bool queuedState;
+    Mutex lock;               // guards busy and the queued write
+    os_semaphore_t start;     // given by write() and warm() to start a job
+    os_semaphore_t done;      // given by the worker when it goes idle
+    Thread *thread;
+  };
+
+  Worker _workers[WEMOFANOUT_MAX];
+
+  static os_thread_return_t run(void *param) {
+    Worker *worker = (Worker *)param;
+    while(true) {
+      os_semaphore_take(worker->start, CONCURRENT_WAIT_FOREVER, false);
+      bool more = true;
+      while(more) {
+        if(worker->warm) {
+          worker->warmOutlet = wemoConnect(worker->outlet, worker->client) ? worker->outlet : -1;
+        }
+        else {
+          if(worker->warmOutlet != worker->outlet) {
+            worker->client.stop();    // open to another outlet, don't send there
+          }
+          worker->warmOutlet = -1;
+          worker->acknowledged = wemoWrite(worker->outlet, worker->state, worker->client);
+        }
+
+        // Run a write queued meanwhile, or go idle. done is given under
+        // the lock so write() can't start a job and then see this one's.
+        worker->lock.lock();
+        more = worker->queued;
+        if(more) {
+          worker->queued = false;
+          worker->outlet = worker->queuedOutlet;
+          worker->state = worker->queuedState;
+          worker->warm = false;
+        }
+        else {
+          worker->busy = false;
+          os_semaphore_give(worker->done, false);
+        }
+        worker->lock.unlock();
+      }
+    }
+  }
+
+  public:
+    WemoFanout() {
+      for(int i = 0; i < WEMOFANOUT_MAX; i++) {
+        _workers[i].busy = false;
+        _workers[i].queued = false;
+        _workers[i].warmOutlet = -1;
+        _workers[i].thread = NULL;
+      }
+    }
+
+    void begin() {
+      for(int i = 0; i < WEMOFANOUT_MAX; i++) {
+        Worker &worker = _workers[i];
+        if(worker.thread == NULL) {
+          os_semaphore_create(&worker.start, 1, 0);
+          os_semaphore_create(&worker.done, 1, 0);
+          worker.thread = new Thread("wemo", run, &worker);
+        }
+      }
+    }
+
+    // Switch the outlets in parallel and wait until they have all answered
+    // or the deadline passes. Returns how many acknowledged the change. An
+    // outlet still busy (a warm-up, or a write that ran past its deadline)
+    // gets the request as soon as it's free; if it's asked again before
+    // then only the latest state is sent. Nothing is sent while Wi-Fi is
+    // down.
+    int write(const int *outlets, int count, bool wemoState, unsigned int deadlineMs=WEMOFANOUT_DEADLINE) {
+      bool started[WEMOFANOUT_MAX] = {};
+      system_tick_t start = millis();
+      int acknowledged = 0;
+
+      if(!WiFi.ready()) {
+        return 0;
+      }
+      if(count > WEMOFANOUT_MAX) {
+        count = WEMOFANOUT_MAX;
+      }
+      for(int i = 0; i < count; i++) {
+        Worker &worker = _workers[i];
+        if(worker.thread == NULL) {
+          continue;
+        }
+        worker.lock.lock();
+        if(worker.busy) {
+          worker.queued = true;
+          worker.queuedOutlet = outlets[i];
+          worker.queuedState = wemoState;
+        }
+        else {
+          os_semaphore_take(worker.done, 0, false);   // left over from a batch that ran late
+          worker.outlet = outlets[i];
+          worker.state = wemoState;
+          worker.warm = false;
+          worker.busy = true;
+          os_semaphore_give(worker.start, false);
+        }
+        worker.lock.unlock();
+        started[i] = true;
+      }
+
+      for(int i = 0; i < count; i++) {
+        if(!started[i]) {
+          continue;
+        }
+        system_tick_t elapsed = millis() - start;
+        system_tick_t remaining = elapsed < deadlineMs ? deadlineMs - elapsed : 0;
+        if(os_semaphore_take(_workers[i].done, remaining, false) == 0 && _workers[i].acknowledged) {
+          acknowledged++;
+        }
+      }
+      return acknowledged;
+    }
+
+    // Open connections to the outlets in the background, so the next
+    // write() to them costs one round trip instead of a connect as well.
+    // Returns right away. A connection the outlet drops before then is
+    // simply reopened, and a busy outlet is left alone.
+    void warm(const int *outlets, int count) {
+      if(!WiFi.ready()) {
+        return;
+      }
+      if(count > WEMOFANOUT_MAX) {
+        count = WEMOFANOUT_MAX;
+      }
+      for(int i = 0; i < count; i++) {
+        Worker &worker = _workers[i];
+        if(worker.thread == NULL) {
+          continue;
+        }
+        worker.lock.lock();
+        if(!worker.busy) {
+          os_semaphore_take(worker.done, 0, false);
+          worker.outlet = outlets[i];
+          worker.warm = true;
+          worker.busy = true;
+          os_semaphore_give(worker.start, false);
+        }
+        worker.lock.unlock();
+      }
+    }
+};
+
+#endif // _WEMOFANOUT_H_
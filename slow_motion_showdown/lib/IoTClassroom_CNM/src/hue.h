@@ -9,6 +9,9 @@
  */
 
 #include "application.h"
+#include "HttpResponse.h"
+#include "CircuitBreaker.h"
+#include "HueJson.h"
 
 /* Usage:
  * setHue(int lightNum, bool HueOn, int HueColor, int HueBright, int HueSat);
@@ -19,14 +22,29 @@
  *    HueBright is the brightness between 0 and 255
  *    HueSat is the saturation between 0 and 255
  *
+ * setHueGroup(int groupNum, ...) takes the same arguments and changes
+ * every light in a bridge group with one request (group 0 is all lights).
+ * hueGroupFor(name, lights, count) finds or makes the group for a set of
+ * lights, once at startup. recallHueScene(groupNum, sceneId) recalls a
+ * scene stored on the bridge. hueWarm() opens the bridge connection ahead
+ * of a command.
+ *
  * NOTE: In your main code, Ethernet.begin(mac) needs to be called
  */
 
 
 // Hue Configuration
-const char hueHubIP[] = "192.168.1.5";       // Hue hub IP
+// Define HUE_HUB_IP / HUE_HUB_PORT at build time to talk to another
+// bridge, e.g. the host build's device_server.
+#ifndef HUE_HUB_IP
+#define HUE_HUB_IP "192.168.1.5"
+#endif
+#ifndef HUE_HUB_PORT
+#define HUE_HUB_PORT 80
+#endif
+const char hueHubIP[] = HUE_HUB_IP;       // Hue hub IP
 const char hueUsername[] = "MQlZziRO0Wai5MsMHll8xAUAQqw85Qrr8tM37F3T";
-const int hueHubPort = 80;   // HTTP: 80, HTTPS: 443, HTTP-PROXY: 8080
+const int hueHubPort = HUE_HUB_PORT;   // HTTP: 80, HTTPS: 443, HTTP-PROXY: 8080
 
 //  Hue variables
 bool hueOn;  // on/off
@@ -44,113 +62,324 @@ int HueIndigo = 47500;
 int HueViolet = 50000;
 int HueRainbow[] = {HueRed, HueOrange, HueYellow, HueGreen, HueBlue, HueIndigo, HueViolet};
 
-TCPClient HueClient;
+TCPClient HueClient;          // kept open between commands, see hueRequest()
+const int hueTimeout = 1000;  // ms budget for each request's reply
+CircuitBreaker hueBreaker;    // a bridge that stops answering is skipped for a while
+
+//  Last state each light (or group) is known to be in: what the bridge
+//  acknowledged, or what getHue() read back. setHue() skips commands that
+//  wouldn't change it. Like HueClient, use from one thread at a time.
+const int HUECACHE_SIZE = 16;
+struct HueCacheEntry {
+  int num;
+  bool group;
+  bool valid;
+  bool on;
+  int color, bright, sat;
+};
+HueCacheEntry hueCache[HUECACHE_SIZE];
 
 bool setHue(int lightNum, bool HueOn, int HueColor=HueBlue, int HueBright=255, int HueSat=255);
 bool getHue(int lightNum);
+bool getHue(int lightNum, HueLightState &state);
+bool setHueGroup(int groupNum, bool HueOn, int HueColor=HueBlue, int HueBright=255, int HueSat=255);
+bool recallHueScene(int groupNum, const char *sceneId);
+int hueGroupFor(const char *name, const int *lights, int count);
+bool hueCacheMatches(int num, bool group, bool HueOn, int HueColor, int HueBright, int HueSat);
+void hueCacheStore(int num, bool group, bool valid, bool HueOn, int HueColor, int HueBright, int HueSat);
+bool hueRequest(const char *method, const char *path, const char *body, HueJsonTokenizer *parser=NULL);
+bool hueCommand(const char *path, const char *body);
+int hueSend(const char *method, const char *path, const char *body, HueJsonTokenizer *parser, bool &complete);
+bool hueWarm();
 
 bool setHue(int lightNum, bool HueOn, int HueColor, int HueBright, int HueSat) {
 
-  static int PrevLightNum,PrevOn, PrevColor, PrevBright, PrevSat;
+  char command[64];
+  char path[96];
+  bool executed;
+
+  if(hueCacheMatches(lightNum, false, HueOn, HueColor, HueBright, HueSat)) {
+    Serial.printf("No Change - Cancelling CMD\n");
+    return false;
+  }
+
+  if(HueOn == true) {
+    snprintf(command, sizeof(command), "{\"on\":true,\"sat\":%i,\"bri\":%i,\"hue\":%i}", HueSat, HueBright, HueColor);
+  }
+  else {
+    snprintf(command, sizeof(command), "{\"on\":false}");
+  }
+
+  Serial.printf("Sending Command to Hue: %s\n",command);
+  snprintf(path, sizeof(path), "/api/%s/lights/%i/state", hueUsername, lightNum);
+  executed = hueCommand(path, command);
+  hueCacheStore(lightNum, false, executed, HueOn, HueColor, HueBright, HueSat);
+  return executed;
+}
+
 
-  String command = "";  
+//  Set every light in a group with one request
+bool setHueGroup(int groupNum, bool HueOn, int HueColor, int HueBright, int HueSat) {
+  char command[64];
+  char path[96];
+  bool executed;
 
-  if((lightNum==PrevLightNum)&&(HueOn==PrevOn)&&(HueColor==PrevColor)&&(HueBright==PrevBright)&&(HueSat==PrevSat)) {
+  if(hueCacheMatches(groupNum, true, HueOn, HueColor, HueBright, HueSat)) {
     Serial.printf("No Change - Cancelling CMD\n");
     return false;
   }
-  PrevLightNum = lightNum;
-  PrevOn = HueOn;
-  PrevColor=HueColor;
-  PrevBright=HueBright;
-  PrevSat=HueSat;
 
   if(HueOn == true) {
-    /*
-    command = "{\"on\":true,\"sat\":255,\"bri\":255,\"hue\":";
-    command = command + String(HueColor) + "}";
-    */
-    
-    command = "{\"on\":true,\"sat\":";
-    command = command + String(HueSat) + ",\"bri\":";
-    command = command + String(HueBright) + ",\"hue\":";
-    command = command + String(HueColor) + "}";
+    snprintf(command, sizeof(command), "{\"on\":true,\"sat\":%i,\"bri\":%i,\"hue\":%i}", HueSat, HueBright, HueColor);
   }
   else {
-    command = "{\"on\":false}";
-  }
-
-  if (HueClient.connect(hueHubIP, hueHubPort)) {
-    //while (HueClient.connected())
-    //{
-      // Serial.println("Sending Command to Hue");
-      // Serial.println(command);
-      Serial.printf("Sending Command to Hue: %s\n",command.c_str());
-      HueClient.print("PUT /api/");
-      HueClient.print(hueUsername);
-      HueClient.print("/lights/");
-      HueClient.print(lightNum);  // hueLight zero based, add 1
-      //  HueClient.println("/state");
-      HueClient.println("/state HTTP/1.1");
-      HueClient.println("keep-alive");
-      HueClient.print("Host: ");
-      HueClient.println(hueHubIP);
-      HueClient.print("Content-Length: ");
-      HueClient.println(command.length());
-      HueClient.println("Content-Type: text/plain;charset=UTF-8");
-      HueClient.println();  // blank line before body
-      HueClient.println(command);  // Hue command
-      HueClient.readString();
-      // Serial.println("From Hue");
-      // Serial.println(HueClient.readString()); // To close connection
-    HueClient.stop();
-    return true;  // command executed
-  }
-  else
-    return false;  // command failed
+    snprintf(command, sizeof(command), "{\"on\":false}");
+  }
+
+  Serial.printf("Sending Command to Hue group %i: %s\n",groupNum,command);
+  snprintf(path, sizeof(path), "/api/%s/groups/%i/action", hueUsername, groupNum);
+  executed = hueCommand(path, command);
+  hueCacheStore(groupNum, true, executed, HueOn, HueColor, HueBright, HueSat);
+  return executed;
 }
 
+//  Recall a scene stored on the bridge for a group
+bool recallHueScene(int groupNum, const char *sceneId) {
+  char command[64];
+  char path[96];
+
+  snprintf(command, sizeof(command), "{\"scene\":\"%s\"}", sceneId);
+  snprintf(path, sizeof(path), "/api/%s/groups/%i/action", hueUsername, groupNum);
+  hueCacheStore(groupNum, true, false, false, 0, 0, 0);   // the scene decides the state
+  return hueCommand(path, command);
+}
 
+//  Find the bridge group with this name and make its lights match, or
+//  create it. Returns the group number, or 0 if the bridge didn't answer.
+//  Call once at startup; the group stays on the bridge between runs.
+int hueGroupFor(const char *name, const int *lights, int count) {
+  char command[160];
+  char path[96];
+  HueGroupFinder finder(name);
+  int length;
+
+  length = snprintf(command, sizeof(command), "{\"name\":\"%s\",\"lights\":[", name);
+  for(int i = 0; i < count && length < (int)sizeof(command); i++) {
+    length += snprintf(command + length, sizeof(command) - length, "%s\"%i\"", i ? "," : "", lights[i]);
+  }
+  if(length < (int)sizeof(command)) {
+    snprintf(command + length, sizeof(command) - length, "]}");
+  }
+
+  snprintf(path, sizeof(path), "/api/%s/groups", hueUsername);
+  if(!hueRequest("GET", path, NULL, &finder)) {
+    return 0;
+  }
+  if(finder.id != 0) {
+    int groupNum = finder.id;
+    snprintf(path, sizeof(path), "/api/%s/groups/%i", hueUsername, groupNum);
+    return hueCommand(path, command) ? groupNum : 0;
+  }
+  if(!hueRequest("POST", path, command, &finder)) {
+    return 0;
+  }
+  return finder.id;
+}
+
+//  Read a light's state into hueOn, hueBri and hueHue
 bool getHue(int lightNum) {
-  if (HueClient.connect(hueHubIP, hueHubPort))
-  {
-    HueClient.print("GET /api/");
-    HueClient.print(hueUsername);
-    HueClient.print("/lights/");
-    HueClient.print(lightNum);  
-    HueClient.println(" HTTP/1.1");
-    HueClient.print("Host: ");
-    HueClient.println(hueHubIP);
-    HueClient.println("Content-type: application/json");
-    HueClient.println("keep-alive");
-    HueClient.println();
-    //while (HueClient.connected())
-    //{
-    //  if (HueClient.available()) {
-        Serial.println();
-        Serial.println(HueClient.readString());
-        Serial.println();
-        HueClient.findUntil("\"on\":", "\0");
-        hueOn = (HueClient.readStringUntil(',') == "true");  // if light is on, set variable to true
-        Serial.print("Hue Status: ");
-        Serial.println(hueOn);
- 
-        HueClient.findUntil("\"bri\":", "\0");
-        hueBri = HueClient.readStringUntil(',').toInt();  // set variable to brightness value
-        Serial.println(hueBri);
-        
-        HueClient.findUntil("\"hue\":", "\0");
-        hueHue = HueClient.readStringUntil(',').toInt();  // set variable to hue value
-        Serial.printf("Hue is\n\n\n %i\n",hueHue);
-        
-        //break;  // not capturing other light attributes yet
-    //  }
-    //}
-    HueClient.stop();
-    return true;  // captured on,bri,hue
-  }
- else
-   return false;  // error reading on,bri,hue
+  HueLightState state;
+
+  if(!getHue(lightNum, state) || !state.has(HUE_FIELD_ON)) {
+    return false;  // error reading on,bri,hue
+  }
+  hueOn = state.on;
+  Serial.print("Hue Status: ");
+  Serial.println(hueOn);
+  if(state.has(HUE_FIELD_BRI)) {
+    hueBri = state.bri;  // set variable to brightness value
+  }
+  Serial.println(hueBri);
+  if(state.has(HUE_FIELD_HUE)) {
+    hueHue = state.hue;  // set variable to hue value
+  }
+  Serial.printf("Hue is\n\n\n %li\n",hueHue);
+  return true;  // captured on,bri,hue
+}
+
+//  Read a light's full state. The reply is parsed as it arrives; fields
+//  it didn't contain are left out of state.fields.
+bool getHue(int lightNum, HueLightState &state) {
+  char path[96];
+  HueStateParser parser;
+
+  snprintf(path, sizeof(path), "/api/%s/lights/%i", hueUsername, lightNum);
+  if(!hueRequest("GET", path, NULL, &parser)) {
+    return false;
+  }
+  state = parser.state;
+  if(state.has(HUE_FIELD_ON | HUE_FIELD_BRI | HUE_FIELD_HUE | HUE_FIELD_SAT)) {
+    hueCacheStore(lightNum, false, true, state.on, state.hue, state.bri, state.sat);
+  }
+  return true;
+}
+
+//  True if the light or group is known to be in this state already
+bool hueCacheMatches(int num, bool group, bool HueOn, int HueColor, int HueBright, int HueSat) {
+  for(int i = 0; i < HUECACHE_SIZE; i++) {
+    HueCacheEntry &entry = hueCache[i];
+    if(entry.valid && entry.num == num && entry.group == group) {
+      if(!HueOn) {
+        return !entry.on;   // off is off, whatever the color
+      }
+      return entry.on && entry.color == HueColor && entry.bright == HueBright && entry.sat == HueSat;
+    }
+  }
+  return false;
+}
+
+//  Record a light or group's state, or forget it (valid false) when a
+//  command failed. A group command changes lights we can't see from here,
+//  and a light command changes the groups it's in, so both forget the
+//  other kind.
+void hueCacheStore(int num, bool group, bool valid, bool HueOn, int HueColor, int HueBright, int HueSat) {
+  int slot = -1;
+  for(int i = 0; i < HUECACHE_SIZE; i++) {
+    HueCacheEntry &entry = hueCache[i];
+    if(entry.valid && entry.num == num && entry.group == group) {
+      slot = i;
+    }
+    else if(entry.valid && (group || entry.group)) {
+      entry.valid = false;
+    }
+  }
+  if(slot < 0) {
+    for(int i = 0; i < HUECACHE_SIZE && slot < 0; i++) {
+      if(!hueCache[i].valid) {
+        slot = i;
+      }
+    }
+  }
+  if(slot < 0) {
+    slot = num % HUECACHE_SIZE;   // full: reuse one, it only costs a resend
+  }
+  hueCache[slot].num = num;
+  hueCache[slot].group = group;
+  hueCache[slot].valid = valid;
+  hueCache[slot].on = HueOn;
+  hueCache[slot].color = HueColor;
+  hueCache[slot].bright = HueBright;
+  hueCache[slot].sat = HueSat;
+}
+
+//  Send one request to the bridge and read its reply, reusing the open
+//  connection if there is one. The bridge drops idle connections, which
+//  only shows up once a request on it gets no reply, so that case is
+//  retried once on a new connection. The reply body is fed to parser if
+//  it's given. True if the bridge answered with 200 OK. Fails at once,
+//  without connecting, if Wi-Fi is down or hueBreaker is open.
+bool hueRequest(const char *method, const char *path, const char *body, HueJsonTokenizer *parser) {
+  if(!WiFi.ready() || !hueBreaker.allow()) {
+    return false;
+  }
+  bool complete = false;
+  int status = hueSend(method, path, body, parser, complete);
+  hueBreaker.record(complete);
+  if(hueBreaker.isOpen()) {
+    Serial.printf("Hue bridge not answering, skipping it for now\n");
+  }
+  return status == 200;  // command executed
+}
+
+//  PUT a command and check the reply. The bridge answers 200 OK even when
+//  it refuses the command (a deleted group, a value out of range) and says
+//  so in the body, so only a reply without an error counts as applied.
+bool hueCommand(const char *path, const char *body) {
+  HueErrorFinder finder;
+
+  if(!hueRequest("PUT", path, body, &finder)) {
+    return false;
+  }
+  if(finder.error) {
+    Serial.printf("Hue bridge refused the command\n");
+    return false;
+  }
+  return true;
+}
+
+//  Open the bridge connection now if it isn't open, so the next command
+//  costs one round trip. The bridge closes connections that sit idle
+//  long enough; hueRequest() reopens those. As with wemoConnect(), only
+//  a failed connect is recorded on hueBreaker, and an open breaker is
+//  left for the next command to probe.
+bool hueWarm() {
+  bool connected;
+  if(HueClient.connected()) {
+    return true;
+  }
+  if(!WiFi.ready() || hueBreaker.isOpen()) {
+    return false;
+  }
+  HueClient.stop();
+  connected = HueClient.connect(hueHubIP, hueHubPort);
+  if(!connected) {
+    hueBreaker.record(false);
+  }
+  return connected;
+}
+
+//  The request itself, for hueRequest(). Returns the HTTP status, 0 if
+//  there was no complete reply; complete is set if the bridge answered.
+int hueSend(const char *method, const char *path, const char *body, HueJsonTokenizer *parser, bool &complete) {
+  char header[256];
+  char chunk[64];
+  int bodyLength = body ? strlen(body) : 0;
+
+  complete = false;
+  for(int attempt = 0; attempt < 2; attempt++) {
+    bool reused = HueClient.connected();
+    if(!reused) {
+      HueClient.stop();
+      if(!HueClient.connect(hueHubIP, hueHubPort)) {
+        return 0;  // command failed
+      }
+    }
+
+    HttpResponse response(HueClient, hueTimeout);
+    int headerLength = snprintf(header, sizeof(header),
+      "%s %s HTTP/1.1\r\n"
+      "Host: %s\r\n"
+      "Connection: keep-alive\r\n"
+      "Content-Type: application/json\r\n"
+      "Content-Length: %i\r\n"
+      "\r\n", method, path, hueHubIP, bodyLength);
+    HueClient.write((const uint8_t *)header, headerLength);
+    if(bodyLength > 0) {
+      HueClient.write((const uint8_t *)body, bodyLength);
+    }
+
+    if(parser) {
+      int n;
+      parser->reset();
+      while((n = response.readBody(chunk, sizeof(chunk))) > 0) {
+        parser->feed(chunk, n);
+      }
+      complete = (n == 0);
+    }
+    else {
+      complete = response.read();
+    }
+    if(!complete || response.closing) {
+      HueClient.stop();
+    }
+    if(complete) {
+      return response.status;
+    }
+    if(!reused || response.status != 0 || response.timedOut) {
+      return 0;  // only a stale connection is worth another try
+    }
+  }
+  return 0;
 }
 
-#endif // _HUE_H_
\ No newline at end of file
+#endif // _HUE_H_
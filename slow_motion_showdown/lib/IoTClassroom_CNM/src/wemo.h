@@ -9,74 +9,130 @@
  */
 
 #include "application.h"
+#include "HttpResponse.h"
+#include "CircuitBreaker.h"
 
 TCPClient WemoClient;
 
-int wemoPort = 49153;
-const char *wemoIP[6] = {"192.168.1.30","192.168.1.31","192.168.1.32","192.168.1.33","192.168.1.34","192.168.1.35"};
+// Define WEMO_IPS (six quoted addresses) / WEMO_PORT at build time to
+// talk to other outlets, e.g. the host build's device_server.
+#ifndef WEMO_IPS
+#define WEMO_IPS "192.168.1.30","192.168.1.31","192.168.1.32","192.168.1.33","192.168.1.34","192.168.1.35"
+#endif
+#ifndef WEMO_PORT
+#define WEMO_PORT 49153
+#endif
+
+int wemoPort = WEMO_PORT;
+const int wemoTimeout = 1000;   // ms budget for each outlet's reply
+const char *wemoIP[6] = {WEMO_IPS};
+CircuitBreaker wemoBreaker[6];  // an outlet that stops answering is skipped for a while
 
 // Function Prototypes
-void switchON(int wemo);
-void switchOFF(int wemo);
-void wemoWrite(int outlet, bool wemoState);
+// Each takes an optional client so outlets can be switched in parallel,
+// one connection per thread (see WemoFanout.h)
+bool switchON(int wemo, TCPClient &client=WemoClient);
+bool switchOFF(int wemo, TCPClient &client=WemoClient);
+bool wemoWrite(int outlet, bool wemoState, TCPClient &client=WemoClient);
+bool wemoSend(int wemo, const char *request, size_t length, TCPClient &client);
+bool wemoConnect(int wemo, TCPClient &client);
 
 // Turn on/off wemo outlets similar to digitalWrite
-void wemoWrite(int outlet, bool wemoState) {
+// Returns true if the outlet acknowledged the change
+bool wemoWrite(int outlet, bool wemoState, TCPClient &client) {
   if(wemoState) {
-    switchON(outlet);
+    return switchON(outlet, client);
   }
   else {
-    switchOFF(outlet);
+    return switchOFF(outlet, client);
   }
 }
 
 
 
-// turn on specified wemo outlet
-void switchON(int wemo) {
-  
-  String data1;
-  
-  Serial.printf("Switching On Wemo #%i\n",wemo);
-  data1+="<?xml version=\"1.0\" encoding=\"utf-8\"?><s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\"><s:Body><u:SetBinaryState xmlns:u=\"urn:Belkin:service:basicevent:1\"><BinaryState>1</BinaryState></u:SetBinaryState></s:Body></s:Envelope>"; // Use HTML encoding for comma's
-  if (WemoClient.connect(wemoIP[wemo],wemoPort)) {
-        WemoClient.println("POST /upnp/control/basicevent1 HTTP/1.1");
-        WemoClient.println("Content-Type: text/xml; charset=utf-8");
-        WemoClient.println("SOAPACTION: \"urn:Belkin:service:basicevent:1#SetBinaryState\"");
-        WemoClient.println("Connection: keep-alive");
-        WemoClient.print("Content-Length: ");
-        WemoClient.println(data1.length());
-        WemoClient.println();
-        WemoClient.print(data1);
-        WemoClient.println();
+//  The two SetBinaryState requests, headers and all, built at compile time
+//  so each goes out in one write with no heap use. WEMO_SOAP_LENGTH must
+//  match the envelope; the static_asserts below check it.
+#define WEMO_STR(x) #x
+#define WEMO_XSTR(x) WEMO_STR(x)
+#define WEMO_SOAP_LENGTH 299
+#define WEMO_SOAP_BODY(state) "<?xml version=\"1.0\" encoding=\"utf-8\"?><s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\"><s:Body><u:SetBinaryState xmlns:u=\"urn:Belkin:service:basicevent:1\"><BinaryState>" state "</BinaryState></u:SetBinaryState></s:Body></s:Envelope>"
+#define WEMO_SOAP_REQUEST(state) \
+  "POST /upnp/control/basicevent1 HTTP/1.1\r\n" \
+  "Content-Type: text/xml; charset=utf-8\r\n" \
+  "SOAPACTION: \"urn:Belkin:service:basicevent:1#SetBinaryState\"\r\n" \
+  "Connection: keep-alive\r\n" \
+  "Content-Length: " WEMO_XSTR(WEMO_SOAP_LENGTH) "\r\n" \
+  "\r\n" \
+  WEMO_SOAP_BODY(state)
+
+static_assert(sizeof(WEMO_SOAP_BODY("1")) - 1 == WEMO_SOAP_LENGTH, "WEMO_SOAP_LENGTH doesn't match the ON envelope");
+static_assert(sizeof(WEMO_SOAP_BODY("0")) - 1 == WEMO_SOAP_LENGTH, "WEMO_SOAP_LENGTH doesn't match the OFF envelope");
+
+constexpr char wemoOnRequest[] = WEMO_SOAP_REQUEST("1");
+constexpr char wemoOffRequest[] = WEMO_SOAP_REQUEST("0");
+
+//  Send one of the requests above to an outlet and read the reply. Fails
+//  at once, without connecting, if Wi-Fi is down or the outlet's breaker
+//  is open. A client already open (see wemoConnect) must be open to this
+//  outlet; it's used as is, and if the outlet dropped it while it sat
+//  idle the request is retried once on a new connection.
+bool wemoSend(int wemo, const char *request, size_t length, TCPClient &client) {
+  bool acknowledged = false;
+  bool answered = false;
+  if (!WiFi.ready() || !wemoBreaker[wemo].allow()) {
+    return false;
+  }
+  for (int attempt = 0; attempt < 2 && !answered; attempt++) {
+    bool warm = client.connected();
+    if (!warm && !client.connect(wemoIP[wemo],wemoPort)) {
+      break;
     }
+    HttpResponse response(client, wemoTimeout);
+    client.write((const uint8_t *)request, length);
+    answered = response.read();
+    acknowledged = answered && response.status == 200;
+    client.stop();
+    if (!warm || response.status != 0 || response.timedOut) {
+      break;  // only a stale connection is worth another try
+    }
+  }
+  client.stop();
+  wemoBreaker[wemo].record(answered);
+  if (wemoBreaker[wemo].isOpen()) {
+    Serial.printf("Wemo #%i not answering, skipping it for now\n",wemo);
+  }
+  return acknowledged;
+}
 
-  if (WemoClient.connected()) {
-     WemoClient.stop();
+//  Open a connection to an outlet ahead of a request, so the request
+//  itself costs one round trip. The next wemoSend() on client uses it.
+//  Only a reply shows an outlet is working, so a connect never closes
+//  the breaker: an open one is left to the next real request to probe,
+//  and only a failed connect is recorded.
+bool wemoConnect(int wemo, TCPClient &client) {
+  bool connected;
+  if (!WiFi.ready() || wemoBreaker[wemo].isOpen()) {
+    return false;
+  }
+  client.stop();
+  connected = client.connect(wemoIP[wemo],wemoPort);
+  if (!connected) {
+    wemoBreaker[wemo].record(false);
   }
+  return connected;
+}
+
+// turn on specified wemo outlet
+bool switchON(int wemo, TCPClient &client) {
+  Serial.printf("Switching On Wemo #%i\n",wemo);
+  return wemoSend(wemo, wemoOnRequest, sizeof(wemoOnRequest) - 1, client);
 }
 
 // turn off wemo outlet specified
-void switchOFF(int wemo){
-  String data1;
-  
+bool switchOFF(int wemo, TCPClient &client){
   Serial.printf("Switching Off Wemo #%i \n",wemo);
-  data1+="<?xml version=\"1.0\" encoding=\"utf-8\"?><s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\"><s:Body><u:SetBinaryState xmlns:u=\"urn:Belkin:service:basicevent:1\"><BinaryState>0</BinaryState></u:SetBinaryState></s:Body></s:Envelope>"; // Use HTML encoding for comma's
-  if (WemoClient.connect(wemoIP[wemo],wemoPort)) {
-        WemoClient.println("POST /upnp/control/basicevent1 HTTP/1.1");
-        WemoClient.println("Content-Type: text/xml; charset=utf-8");
-        WemoClient.println("SOAPACTION: \"urn:Belkin:service:basicevent:1#SetBinaryState\"");
-        WemoClient.println("Connection: keep-alive");
-        WemoClient.print("Content-Length: ");
-        WemoClient.println(data1.length());
-        WemoClient.println();
-        WemoClient.print(data1);
-        WemoClient.println();
-    }
-   
-  if (WemoClient.connected()) {
-     WemoClient.stop();
-  }
+  return wemoSend(wemo, wemoOffRequest, sizeof(wemoOffRequest) - 1, client);
 }
 
 #endif // _WEMO_H_
\ No newline at end of file
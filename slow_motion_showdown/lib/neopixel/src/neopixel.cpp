@@ -76,7 +76,27 @@
   #define pinLO(_pin) (nrf_gpio_pin_clear(NRF_GPIO_PIN_MAP(PIN_MAP2[_pin].gpio_port, PIN_MAP2[_pin].gpio_pin)))
   #define pinHI(_pin) (nrf_gpio_pin_set(NRF_GPIO_PIN_MAP(PIN_MAP2[_pin].gpio_port, PIN_MAP2[_pin].gpio_pin)))
 #elif (PLATFORM_ID == 32) // HAL_PLATFORM_RTL872X
-  // nothing extra needed for P2
+  // The P2 sends pixels over SPI at 3.125MHz, three SPI bits per pixel bit:
+  // 0b110 for a 1 and 0b100 for a 0. This table holds the 3 SPI bytes for
+  // every possible color byte, built at compile time so show() is a copy.
+  constexpr uint8_t PIX_HI = 0b110;
+  constexpr uint8_t PIX_LO = 0b100;
+
+  struct SpiPixelTable {
+    uint8_t bytes[256][3];
+    constexpr SpiPixelTable() : bytes() {
+      for (int v = 0; v < 256; v++) {
+        uint32_t bits = 0;
+        for (int b = 7; b >= 0; b--) {
+          bits = (bits << 3) | (((v >> b) & 1) ? PIX_HI : PIX_LO);
+        }
+        bytes[v][0] = (uint8_t)(bits >> 16);
+        bytes[v][1] = (uint8_t)(bits >> 8);
+        bytes[v][2] = (uint8_t)bits;
+      }
+    }
+  };
+  static constexpr SpiPixelTable spiPixelTable;
 #else
   #error "*** PLATFORM_ID not supported by this library. PLATFORM should be Particle Core, Photon, Electron, Argon, Boron, Xenon, RedBear Duo, B SoM, B5 SoM, E SoM X, Tracker or P2 ***"
 #endif
@@ -85,14 +105,16 @@
 
 #if (PLATFORM_ID == 32)
 Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, SPIClass& spi, uint8_t t) :
-  begun(false), type(t), brightness(0), pixels(NULL), endTime(0)
+  begun(false), dirty(true), type(t), brightness(0), pixels(NULL), endTime(0),
+  spiArray(NULL), spiArraySize(0), resetOff(0), spiBack(0),
+  dmaBusy(false), dmaTransaction(false)
 {
   updateLength(n);
   spi_ = &spi;
 }
 #else
 Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, uint8_t p, uint8_t t) :
-  begun(false), type(t), brightness(0), pixels(NULL), endTime(0)
+  begun(false), dirty(true), type(t), brightness(0), pixels(NULL), endTime(0)
 {
   updateLength(n);
   setPin(p);
@@ -103,6 +125,9 @@ Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, uint8_t p, uint8_t t) :
 Adafruit_NeoPixel::~Adafruit_NeoPixel() {
   if (pixels) free(pixels);
 #if (PLATFORM_ID == 32)
+  waitShowComplete();
+  if (dmaOwner[spi_->interface()] == this) dmaOwner[spi_->interface()] = NULL;
+  if (spiArray) free(spiArray);
   spi_->end();
 #else
   if (begun) pinMode(pin, INPUT);
@@ -128,6 +153,34 @@ void Adafruit_NeoPixel::updateLength(uint16_t n) {
   } else {
     numLEDs = numBytes = 0;
   }
+  dirty = true;
+
+#if (PLATFORM_ID == 32)
+  // The SPI encode buffers live as long as the pixel buffer, so show()
+  // doesn't touch the heap. There are two so showAsync() can encode the
+  // next frame while DMA sends the last one. The reset padding at each
+  // end is zeroed here once; show() only rewrites the pixel bits between.
+  waitShowComplete();
+  if (spiArray) free(spiArray);
+
+  switch (type) {
+    case WS2812B: { // WS2812, WS2812B & WS2813 = 300us reset pulse
+        resetOff = 120; // 300us / (1/3125000Mhz) / 8bits_per_byte
+      } break;
+    case WS2812B_FAST: // WS2812B_FAST = 50us reset pulse
+    default: {   // default = 50us reset pulse
+        resetOff = 20;
+      } break;
+  }
+
+  constexpr uint8_t numBitsPerBit = 3; // How many SPI bits represent one neopixel bit
+  spiArraySize = (numBytes * numBitsPerBit) + resetOff + resetOff;
+  if ((spiArray = (uint8_t *)malloc(2 * spiArraySize))) {
+    memset(spiArray, 0, 2 * spiArraySize);
+  } else {
+    spiArraySize = 0;
+  }
+#endif // #if (PLATFORM_ID == 32)
 }
 
 void Adafruit_NeoPixel::begin(void) {
@@ -176,6 +229,87 @@ void Adafruit_NeoPixel::begin(void) {
   begun = true;
 }
 
+#if (PLATFORM_ID == 32)
+Adafruit_NeoPixel *Adafruit_NeoPixel::dmaOwner[HAL_PLATFORM_SPI_NUM] = {};
+
+// DMA completion callbacks. They run in interrupt context and take no
+// argument, so there is one per SPI interface and it only clears the busy
+// flag; the transaction is ended from thread context in isShowComplete().
+void Adafruit_NeoPixel::dmaDone1(void) {
+  if (dmaOwner[HAL_SPI_INTERFACE1]) dmaOwner[HAL_SPI_INTERFACE1]->dmaBusy = false;
+}
+
+void Adafruit_NeoPixel::dmaDone2(void) {
+  if (dmaOwner[HAL_SPI_INTERFACE2]) dmaOwner[HAL_SPI_INTERFACE2]->dmaBusy = false;
+}
+
+// Expand the pixel buffer into the back SPI buffer (the one DMA is not
+// sending). Returns it, or NULL if the strip can't be shown.
+uint8_t *Adafruit_NeoPixel::encodeSpiFrame(void) {
+  if (getType() != WS2812B) { // WS2812 WS2812B and WS2813 supported for P2
+    Log.error("Pixel type not supported!");
+    return NULL;
+  }
+
+  if (spiArray == NULL) {
+    Log.error("Not enough memory available!");
+    return NULL;
+  }
+
+  uint8_t *frame = spiArray + spiBack * spiArraySize;
+
+  // expand pixel data and pack into spi buffer
+  const uint8_t *src = pixels;
+  uint8_t *dst = frame + resetOff;
+  for (uint16_t i = 0; i < numBytes; i++) {
+    const uint8_t *spiBytes = spiPixelTable.bytes[*src++];
+    *dst++ = spiBytes[0];
+    *dst++ = spiBytes[1];
+    *dst++ = spiBytes[2];
+  }
+  return frame;
+}
+
+// Like show(), but returns as soon as the frame is handed to DMA. The
+// pixel buffer is copied into the back SPI buffer first, so the sketch can
+// draw the next frame right away. Waits only if the previous frame is
+// still being sent.
+void Adafruit_NeoPixel::showAsync(void) {
+  if(!pixels || !dirty) return;
+  dirty = false;
+
+  uint8_t *frame = encodeSpiFrame();
+  if (frame == NULL) {
+    return;
+  }
+
+  waitShowComplete();
+  spi_->beginTransaction();
+  dmaTransaction = true;
+  dmaBusy = true;
+  dmaOwner[spi_->interface()] = this;
+  spi_->transfer(frame, nullptr, spiArraySize,
+                 (spi_->interface() == HAL_SPI_INTERFACE1) ? dmaDone1 : dmaDone2);
+  spiBack ^= 1;
+}
+
+// True once the last showAsync() frame has been sent
+bool Adafruit_NeoPixel::isShowComplete(void) {
+  if (dmaBusy) return false;
+  if (dmaTransaction) {
+    dmaTransaction = false;
+    spi_->endTransaction();
+  }
+  return true;
+}
+
+void Adafruit_NeoPixel::waitShowComplete(void) {
+  while (!isShowComplete()) {
+    delayMicroseconds(10);
+  }
+}
+#endif // #if (PLATFORM_ID == 32)
+
 // Set the output pin number
 void Adafruit_NeoPixel::setPin(uint8_t p) {
     if (begun) {
@@ -186,11 +320,16 @@ void Adafruit_NeoPixel::setPin(uint8_t p) {
         pinMode(p, OUTPUT);
         digitalWrite(p, LOW);
     }
+    dirty = true;   // the strip on the new pin hasn't been sent anything
 }
 
 void Adafruit_NeoPixel::show(void) {
   if(!pixels) return;
 
+  // Nothing changed since the last frame, the strip already shows it
+  if(!dirty) return;
+  dirty = false;
+
 #if (PLATFORM_ID != 32)
   // Data latch = 24 or 50 microsecond pause in the output stream.  Rather than
   // put a delay at the end of the function, the ending time is noted and
@@ -873,51 +1012,17 @@ void Adafruit_NeoPixel::show(void) {
   __enable_irq();
 
 #elif (PLATFORM_ID == 32)
-  if (getType() != WS2812B) { // WS2812 WS2812B and WS2813 supported for P2
-    Log.error("Pixel type not supported!");
+  uint8_t *frame = encodeSpiFrame();
+  if (frame == NULL) {
     return;
   }
 
-  constexpr uint8_t PIX_HI = 0b110;
-  constexpr uint8_t PIX_LO = 0b100;
-
-  uint16_t resetOff = 120; // 300us / (1/3125000Mhz) / 8bits_per_byte
-  switch (type) {
-    case WS2812B: { // WS2812, WS2812B & WS2813 = 300us reset pulse
-        resetOff = 120;
-      } break;
-    case WS2812B_FAST: // WS2812B_FAST = 50us reset pulse
-    default: {   // default = 50us reset pulse
-        resetOff = 20;
-      } break;
-  }
-
-  constexpr uint8_t numBitsPerBit = 3; // How many SPI bits represent one neopixel bit
-  uint32_t spiArraySize = (numBytes * numBitsPerBit) + resetOff + resetOff;
-  uint8_t* spiArray = NULL;
-  spiArray = (uint8_t*) malloc(spiArraySize);
-
-  if (spiArray == NULL) {
-    Log.error("Not enough memory available!");
-    return;
-  }
-
-  memset(spiArray, 0, spiArraySize);
-  // expand pixel data and pack into spi buffer
-  for (int x = 0; x < numPixels(); x++) {
-    for (int s = 0; s < 3; s++) {
-      spiArray[(x*9)+(s*3)+0+resetOff] = ((0x80 & pixels[(x*3)+s])?(PIX_HI << 5):(PIX_LO << 5)) + ((0x40 & pixels[(x*3)+s])?(PIX_HI << 2):(PIX_LO << 2)) + ((0x20 & pixels[(x*3)+s])?(0b11):(0b10));
-      spiArray[(x*9)+(s*3)+1+resetOff] = 0 /* bit 7 always 0 */ + ((0x10 & pixels[(x*3)+s])?(PIX_HI << 4):(PIX_LO << 4)) + ((0x08 & pixels[(x*3)+s])?(PIX_HI << 1):(PIX_LO << 1)) + 1 /* bit 0 always 1 */;
-      spiArray[(x*9)+(s*3)+2+resetOff] = ((0x04 & pixels[(x*3)+s])?(0b10 << 6):(0b00 << 6)) + ((0x02 & pixels[(x*3)+s])?(PIX_HI << 3):(PIX_LO << 3)) + ((0x01 & pixels[(x*3)+s])?(PIX_HI):(PIX_LO));
-    }
-  }
-
+  // The SPI bus may still be busy with a frame from showAsync()
+  waitShowComplete();
   spi_->beginTransaction();
-  spi_->transfer(spiArray, nullptr, spiArraySize, nullptr);
+  spi_->transfer(frame, nullptr, spiArraySize, nullptr);
   spi_->endTransaction();
 
-  free(spiArray);
-
 #elif HAL_PLATFORM_NRF52840 // Argon, Boron, Xenon, B SoM, B5 SoM, E SoM X, Tracker
 // [[[Begin of the Neopixel NRF52 EasyDMA implementation
 //                                    by the Hackerspace San Salvador]]]
@@ -1218,6 +1323,7 @@ void Adafruit_NeoPixel::setPixelColor(
       b = (b * brightness) >> 8;
     }
     uint8_t *p = &pixels[n * 3];
+    uint8_t before[3] = { p[0], p[1], p[2] };
     switch(type) {
       case WS2812B: // WS2812, WS2812B & WS2813 is GRB order.
       case WS2812B_FAST:
@@ -1241,6 +1347,9 @@ void Adafruit_NeoPixel::setPixelColor(
           *p = b;
         } break;
     }
+    if(memcmp(before, &pixels[n * 3], 3)) {
+      dirty = true; // Only a real change needs sending
+    }
   }
 }
 
@@ -1255,6 +1364,8 @@ void Adafruit_NeoPixel::setPixelColor(
       w = (w * brightness) >> 8;
     }
     uint8_t *p = &pixels[n * (type==SK6812RGBW?4:3)];
+    uint8_t before[4];
+    memcpy(before, p, (type==SK6812RGBW?4:3));
     switch(type) {
       case WS2812B: // WS2812, WS2812B & WS2813 is GRB order.
       case WS2812B_FAST:
@@ -1284,6 +1395,9 @@ void Adafruit_NeoPixel::setPixelColor(
           *p = b;
         } break;
     }
+    if(memcmp(before, &pixels[n * (type==SK6812RGBW?4:3)], (type==SK6812RGBW?4:3))) {
+      dirty = true; // Only a real change needs sending
+    }
   }
 }
 
@@ -1301,6 +1415,8 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
       b = (b * brightness) >> 8;
     }
     uint8_t *p = &pixels[n * (type==SK6812RGBW?4:3)];
+    uint8_t before[4];
+    memcpy(before, p, (type==SK6812RGBW?4:3));
     switch(type) {
       case WS2812B: // WS2812, WS2812B & WS2813 is GRB order.
       case WS2812B_FAST:
@@ -1331,6 +1447,9 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
           *p = b;
         } break;
     }
+    if(memcmp(before, &pixels[n * (type==SK6812RGBW?4:3)], (type==SK6812RGBW?4:3))) {
+      dirty = true; // Only a real change needs sending
+    }
   }
 }
 
@@ -1468,6 +1587,7 @@ void Adafruit_NeoPixel::setBrightness(uint8_t b) {
       *ptr++ = (c * scale) >> 8;
     }
     brightness = newBrightness;
+    dirty = true;
   }
 }
 
@@ -1477,5 +1597,17 @@ uint8_t Adafruit_NeoPixel::getBrightness(void) const {
 }
 
 void Adafruit_NeoPixel::clear(void) {
-  memset(pixels, 0, numBytes);
+  for(uint16_t i=0; i<numBytes; i++) {
+    if(pixels[i]) {
+      memset(pixels, 0, numBytes);
+      dirty = true;
+      break;
+    }
+  }
+}
+
+// Make the next show() send the strip even if no pixel changed, e.g.
+// after writing colors through getPixels() or if the strip lost power.
+void Adafruit_NeoPixel::invalidate(void) {
+  dirty = true;
 }
@@ -95,7 +95,16 @@ class Adafruit_NeoPixel {
     setColorDimmed(uint16_t aLedNumber, byte aRed, byte aGreen, byte aBlue, byte aBrightness),
     setColorDimmed(uint16_t aLedNumber, byte aRed, byte aGreen, byte aBlue, byte aWhite, byte aBrightness),
     updateLength(uint16_t n),
-    clear(void);
+    clear(void),
+    invalidate(void);
+#if (PLATFORM_ID == 32)
+  // Non-blocking show() using SPI DMA, see neopixel.cpp
+  void
+    showAsync(void),
+    waitShowComplete(void);
+  bool
+    isShowComplete(void);
+#endif // #if (PLATFORM_ID == 32)
   uint8_t
    *getPixels() const,
     getBrightness(void) const,
@@ -115,7 +124,8 @@ class Adafruit_NeoPixel {
  private:
 
   bool
-    begun;         // true if begin() previously called
+    begun,         // true if begin() previously called
+    dirty;         // 'pixels' changed since the last show()
   uint16_t
     numLEDs,       // Number of RGB LEDs in strip
     numBytes;      // Size of 'pixels' buffer below
@@ -130,6 +140,25 @@ class Adafruit_NeoPixel {
 #if (PLATFORM_ID == 32)
   SPIClass*
     spi_;
+  uint8_t
+   *spiArray;      // Two SPI encode buffers, kept between show() calls
+  uint32_t
+    spiArraySize;  // Size of one buffer in 'spiArray', reset padding included
+  uint16_t
+    resetOff;      // Bytes of zero padding at each end of a buffer
+  uint8_t
+    spiBack;       // Which buffer the next frame is encoded into
+  volatile bool
+    dmaBusy;       // A showAsync() frame is still being sent
+  bool
+    dmaTransaction; // SPI transaction held open for that frame
+  static Adafruit_NeoPixel
+   *dmaOwner[HAL_PLATFORM_SPI_NUM]; // Instance each DMA callback reports to
+  uint8_t
+   *encodeSpiFrame(void);
+  static void
+    dmaDone1(void),
+    dmaDone2(void);
 #endif
 };
 
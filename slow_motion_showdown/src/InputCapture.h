@@ -0,0 +1,101 @@
+/*
+ * Project: InputCapture.h
+ * Description: Interrupt driven edge capture for the game inputs.
+ *              Each rising edge is stamped with micros() inside the GPIO
+ *              interrupt and queued, so the game can decide who was first
+ *              by timestamp instead of by how often loop() gets around to
+ *              polling the pins.
+ * Author: Daniel Stromberg
+*/
+
+#ifndef _INPUTCAPTURE_H_
+#define _INPUTCAPTURE_H_
+
+#include "Particle.h"
+#include <atomic>
+
+//  One captured edge: which input fired and when (micros()).
+struct InputEvent {
+    uint8_t source;
+    uint32_t timestamp;
+};
+
+//  Fixed size ring buffer filled from GPIO interrupts and emptied by loop().
+//  Only the interrupts move _head and only loop() moves _tail, so neither
+//  side needs to lock. GPIO interrupts share one priority and don't nest,
+//  so pushes from different pins never interleave.
+class InputEventQueue {
+    static const uint8_t QUEUESIZE = 32;    //must be a power of 2
+
+    InputEvent _events[QUEUESIZE];
+    std::atomic<uint8_t> _head;
+    std::atomic<uint8_t> _tail;
+
+  public:
+    InputEventQueue() : _head(0), _tail(0) {}
+
+    //  Called from interrupt context. Drops the event if the queue is full.
+    bool push(uint8_t source, uint32_t timestamp) {
+        uint8_t head = _head.load(std::memory_order_relaxed);
+        uint8_t next = (head + 1) & (QUEUESIZE - 1);
+
+        if (next == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        _events[head].source = source;
+        _events[head].timestamp = timestamp;
+        _head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(InputEvent &event) {
+        uint8_t tail = _tail.load(std::memory_order_relaxed);
+
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        event = _events[tail];
+        _tail.store((tail + 1) & (QUEUESIZE - 1), std::memory_order_release);
+        return true;
+    }
+
+    //  Throw away everything captured so far.
+    void clear() {
+        _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+};
+
+//  Stamps rising edges on one pin into a shared queue.
+//  Edges closer together than the lockout are treated as switch bounce
+//  (or PIR retriggers) and ignored; the first edge always gets through.
+class InputCapture {
+    InputEventQueue &_queue;
+    uint8_t _source;
+    int _pin;
+    uint32_t _lockoutMicros;
+    uint32_t _lastEdge;
+    bool _hasEdge;
+
+  public:
+    InputCapture(InputEventQueue &queue, uint8_t source, int pin, uint32_t lockoutMicros=20000) :
+        _queue(queue), _source(source), _pin(pin), _lockoutMicros(lockoutMicros),
+        _lastEdge(0), _hasEdge(false) {}
+
+    //  Call from setup(), after the pin mode has been set.
+    void begin() {
+        attachInterrupt(_pin, &InputCapture::onEdge, this, RISING);
+    }
+
+    void onEdge() {
+        uint32_t now = micros();
+
+        if (_hasEdge && (now - _lastEdge) < _lockoutMicros) {
+            return;
+        }
+        _hasEdge = true;
+        _lastEdge = now;
+        _queue.push(_source, now);
+    }
+};
+
+#endif // _INPUTCAPTURE_H_
@@ -15,6 +15,8 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include <neopixel.h>
+#include "InputCapture.h"
+#include "GameFrames.h"
 
 
 const int BULBS[] = {5, 3, 1, 2, 4, 6};     //bulb numbers - [0] is my testing bulb
@@ -35,8 +37,18 @@ const int PLAYING = 1;
 const int NOWINNER = 2;
 const int WINNER = 3;
 const int COUNTINGDOWN = 4;
+const int SHOWINGSCORE = 5;
+const int SHOWINGTITLE = 6;
+const int SHOWINGPLAYERS = 7;
+const int SHOWINGWINSCORE = 8;              //score up before the room changes for the winner
 const int ENCODERMAX = 80;
 const int SPEAKERSWITCHPIN = D8;
+const int READYP1INPUT = 0;                 //sources for captured input events
+const int READYP2INPUT = 1;
+const int P1BUTTONINPUT = 2;
+const int P2BUTTONINPUT = 3;
+const int P1MOTIONINPUT = 4;
+const int P2MOTIONINPUT = 5;
 
 
 //CHANGE BELOW CONSTANTS DEPENDING ON Setup
@@ -60,7 +72,18 @@ Button p1Motion(P1MOTIONPIN);
 Button p2Motion(P2MOTIONPIN);
 Button autoModeSwitch(AUTOMODEPIN);
 Encoder myEnc(D4, D5);
+HueQueue hueQueue;                  //sends Hue commands off the game thread
+WemoFanout wemoFanout;              //switches the outlets in parallel
 Button encoderButton(D15);          //also labeled MO, S0
+InputEventQueue inputEvents;
+InputCapture gameInputs[] = {       //timestamps the game inputs from interrupts
+    {inputEvents, READYP1INPUT, READYBUTTONPINP1},
+    {inputEvents, READYP2INPUT, READYBUTTONPINP2},
+    {inputEvents, P1BUTTONINPUT, P1BUTTONPIN},
+    {inputEvents, P2BUTTONINPUT, P2BUTTONPIN},
+    {inputEvents, P1MOTIONINPUT, P1MOTIONPIN},
+    {inputEvents, P2MOTIONINPUT, P2MOTIONPIN}
+};
 
 
 int currentMillis;
@@ -71,6 +94,12 @@ int p2Score = 0;
 int noWinTimer = 0;
 int countdownStart = 0;
 int loser = 0;
+int winner = 0;
+int winnerTimer = 0;
+int scoreTimer = 0;
+int startupTimer = 0;
+uint32_t roundStartMicros = 0;
+int hueGroup = 0;                   //bridge group of the bulbs in use, 0 if it couldn't be set up
 
 
 //Maual Mode variables
@@ -85,13 +114,37 @@ int lastHueUpdate;
 void waitingForPlayers();
 void gameOn();
 void noWin();
+void showWinner();
+void holdScore();
+void holdWinScore();
+void startupTitle();
+void startupPlayers();
 void turnOnOffReadyLEDs(bool onOff);
 void showScore();
 void countDown();
 void gameStartup();
 void lightUpBulbs(bool _onOff, int _color, int _brightness);
 void turnOnOffWemoSwitches(bool _onOff);
+void warmUpNetwork();
 void lightLEDStrip( int _color, bool _onOff = true, int _count = PIXELCOUNT);
+bool firstRoundEvent(InputEvent &_decisive);
+void displayBoth();
+void displayFrameBoth(const uint8_t *frame);
+
+//Device OS calls this for Wire's buffers. Room for a whole frame plus its control byte
+//lets the displays send a full screen in one I2C transaction instead of 32 byte pieces.
+const size_t WIREBUFFERSIZE = SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8 + 1;
+hal_i2c_config_t acquireWireBuffer() {
+    hal_i2c_config_t config = {
+        .size = sizeof(hal_i2c_config_t),
+        .version = HAL_I2C_CONFIG_VERSION_1,
+        .rx_buffer = new (std::nothrow) uint8_t[I2C_BUFFER_LENGTH],
+        .rx_buffer_size = I2C_BUFFER_LENGTH,
+        .tx_buffer = new (std::nothrow) uint8_t[WIREBUFFERSIZE],
+        .tx_buffer_size = WIREBUFFERSIZE
+    };
+    return config;
+}
 
 void setup() {
     Serial.begin(9600);
@@ -111,6 +164,16 @@ void setup() {
         Serial.printf("\n\n");
     }
 
+    if (isWifiOn){
+        wemoFanout.begin();
+    }
+
+    if (USEHUEBULBS){
+        hueGroup = hueGroupFor("Showdown", BULBS, numBulbsToUse);
+        Serial.printf("Hue group %i\n", hueGroup);
+        hueQueue.begin();
+    }
+
     p1OLED.begin(SSD1306_SWITCHCAPVCC, 0x3D);
     p1OLED.clearDisplay();
     p1OLED.setTextColor(WHITE);
@@ -123,6 +186,10 @@ void setup() {
     p2OLED.setTextSize(2);
     p2OLED.display();
 
+    for (InputCapture &input : gameInputs){
+        input.begin();
+    }
+
     // gameStartup();
 
     position = myEnc.read();
@@ -130,6 +197,7 @@ void setup() {
     pixel.begin();
     pixel.setBrightness(30); 
     lightLEDStrip(0x00FFFF);
+    pixel.show();
     // pixel.setPixelColor(0, 0,255,0);
     // pixel.setPixelColor(1, 0,255,0);
     // pixel.show();
@@ -175,6 +243,22 @@ void loop() {
                 break;
             case COUNTINGDOWN:
                 countDown();
+                break;
+            case WINNER:
+                showWinner();
+                break;
+            case SHOWINGSCORE:
+                holdScore();
+                break;
+            case SHOWINGWINSCORE:
+                holdWinScore();
+                break;
+            case SHOWINGTITLE:
+                startupTitle();
+                break;
+            case SHOWINGPLAYERS:
+                startupPlayers();
+                break;
         }
     }
     else {                                //MANUAL CONTROL MODE
@@ -190,8 +274,7 @@ void loop() {
             p1OLED.printf("Now\nadjusting\n");
             p1OLED.printf("%s", hueOrBrightness.c_str());
             Serial.printf("Now adjusting: %s\n", hueOrBrightness.c_str());
-            p1OLED.display();
-            p2OLED.display();
+            displayBoth();
 
             isFirstManualRun = false;
         }
@@ -232,43 +315,35 @@ void loop() {
         // pixel.setPixelColor(1,0,255, 255);
     }
 
-    pixel.show();
+    //  The strip is sent once per pass, by DMA while the next pass runs.
+    //  Everything above only sets the pixel colors.
+    pixel.showAsync();
 
 }
 
 //  Blinks LEDs red when someone loses
 void noWin(){   
     if((currentMillis - noWinTimer) < 4000){
-        p1OLED.clearDisplay();
-        p1OLED.setCursor(0,0);
-        p1OLED.setTextSize(4);
         if(loser ==1){
-            p1OLED.printf("GOLD\nLOST");
+            displayFrameBoth(FRAME_GOLDLOST);
         } else if(loser == 2){
-            p1OLED.printf("BLUE\nLOST");
+            displayFrameBoth(FRAME_BLUELOST);
         }
         else{
-            p1OLED.printf("ERROR");
+            displayFrameBoth(FRAME_NOLOSER);
         }
-        p1OLED.display();
-        p2OLED.display();
-        p1OLED.setTextSize(2);
         
         if((currentMillis - noWinTimer) % 500 < 250){   //pulse red lights every 250ms
             lightLEDStrip(0xFF0000);
         }
         else{
             pixel.clear();
-            pixel.show();
         }
 
     }
     else{
         loser = 0;
-        showScore();
-        lightUpBulbs(false, 0, 0);
-        // setHue(BULBS[0], false, 0, 0, 0);        //turn off bulb
-        gameMode = WAITING;
+        showScore();        //bulbs are turned off once the score has been shown
     }
 }
 
@@ -282,8 +357,16 @@ void gameOn(){
     digitalWrite(PLAYERLEDS[1], HIGH);
 
 
+    //Whichever input fired first decides the round, no matter
+    //how long this pass of loop() took to get here.
+    InputEvent decisive;
+    if(!firstRoundEvent(decisive)){
+        return;
+    }
+    Serial.printf("Round decided %lu us after the start\n", (unsigned long)(decisive.timestamp - roundStartMicros));
+
     //End the game if either player triggers their motion sensor.
-    if (p1Motion.isClicked()){          
+    if (decisive.source == P1MOTIONINPUT){
         Serial.printf("P1 LOSER\n");
         loser = 1;
         p2Score++;
@@ -294,7 +377,7 @@ void gameOn(){
         noWinTimer = currentMillis;
         gameMode = NOWINNER;
     }
-    if (p2Motion.isClicked()){
+    else if (decisive.source == P2MOTIONINPUT){
         loser = 2;
         Serial.printf("P2 LOSER");
         p1Score++;
@@ -307,59 +390,57 @@ void gameOn(){
     }
 
     //Meanwhile, wait for each player to press their own button
-    if(player1Button.isClicked()){
+    else if(decisive.source == P1BUTTONINPUT){
         lightLEDStrip(0xFFDD00);
-        p1OLED.clearDisplay();
-        p1OLED.setCursor(0,0);
-        p1OLED.setTextSize(4);
-        p1OLED.printf("GOLD\nWINS!");
-        p1OLED.display();
-        p2OLED.display();
-        p1OLED.setTextSize(2);
-        delay(1000);
+        displayFrameBoth(FRAME_GOLDWINS);
 
+        winner = 1;
         p1Score = p1Score +5;
-
-        // pixel.setPixelColor(0,0,0,255);
-        // pixel.setPixelColor(1,0,0,255);
-        // pixel.show();
-        showScore();
-        turnOnOffWemoSwitches(false);
-        // wemoWrite(MYWEMO[0], LOW);
-        lightUpBulbs(true, HueYellow, 200);
-        // setHue(BULBS[0], true, HueBlue, 150, 255);        //turn bulb blue
-        delay(2000);
-        gameMode = WAITING;
-        lightUpBulbs(false, HueGreen, 150);
-        // setHue(BULBS[0], false, HueGreen, 150, 255);        //turn bulb off
-        
+        winnerTimer = currentMillis;
+        gameMode = WINNER;
     }
-    else if (player2Button.isClicked()) {
+    else if (decisive.source == P2BUTTONINPUT) {
         lightLEDStrip(0x0000FF);
-        p1OLED.clearDisplay();
-        p1OLED.setCursor(0,0);
-        p1OLED.setTextSize(4);
-        p1OLED.printf("BLUE\nWINS!");
-        p1OLED.display();
-        p2OLED.display();
-        p1OLED.setTextSize(2);
-        delay(1000);
+        displayFrameBoth(FRAME_BLUEWINS);
 
+        winner = 2;
         p2Score = p2Score +5;
-        // pixel.setPixelColor(0,255,255,0);
-        // pixel.setPixelColor(1,255,255,0);
-        // pixel.show();
-        showScore();
-        turnOnOffWemoSwitches(false);
-        // wemoWrite(MYWEMO[0], LOW);
+        winnerTimer = currentMillis;
+        gameMode = WINNER;
+    }
+
+}
+
+//  Hold the winner on screen for a second, then show the score.
+void showWinner(){
+    if((currentMillis - winnerTimer) < 1000){
+        return;
+    }
+
+    showScore();
+    gameMode = SHOWINGWINSCORE;
+}
+
+//  Leave the score up for 2 seconds, then light the room in the
+//  winner's color and hold the score for 2 more.
+void holdWinScore(){
+    if((currentMillis - scoreTimer) < 2000){
+        return;
+    }
+
+    turnOnOffWemoSwitches(false);
+    // wemoWrite(MYWEMO[0], LOW);
+    if(winner == 1){
+        lightUpBulbs(true, HueYellow, 200);
+        // setHue(BULBS[0], true, HueBlue, 150, 255);        //turn bulb blue
+    }
+    else {
         lightUpBulbs(true, HueBlue, 200);
         // setHue(BULBS[0], true, HueYellow, 150, 255);        //turn bulb yellow
-        delay(2000);
-        gameMode = WAITING;
-        lightUpBulbs(false, HueGreen, 150);
-        // setHue(BULBS[0], false, HueGreen, 150, 255);        //turn bulb off
     }
-
+    winner = 0;
+    scoreTimer = currentMillis;
+    gameMode = SHOWINGSCORE;
 }
 
 //  Wait for players to press ready buttons while instructing them to do so.
@@ -367,12 +448,7 @@ void waitingForPlayers(){
     turnOnOffReadyLEDs(true);
     digitalWrite(PLAYERLEDS[0], LOW);
     digitalWrite(PLAYERLEDS[1], LOW);
-    p1OLED.clearDisplay();
-    p1OLED.setCursor(0,0);
-    p1OLED.printf("Place both");
-    p1OLED.printf("hands on\nthe white\nbuttons");
-    p1OLED.display();
-    p2OLED.display();
+    displayFrameBoth(FRAME_PLACEHANDS);
 
     lightLEDStrip(0xFF0000);
     // pixel.setPixelColor(0,255,0,0);
@@ -381,46 +457,28 @@ void waitingForPlayers(){
 
     if (readyButtonP1.isPressed() && readyButtonP2.isPressed()){
         pixel.clear();
-        pixel.show();
         turnOnOffReadyLEDs(false);
 
         countdownStart = currentMillis;
+        warmUpNetwork();
         gameMode = COUNTINGDOWN;        
     }
-    pixel.show();
 }
 
 //  Give both players a countdown to the start of the round.
 void countDown(){
     if((currentMillis - countdownStart) < 5000){
         if((currentMillis - countdownStart) < 2000){
-            p1OLED.clearDisplay();
-            p1OLED.setCursor(0,0);
-            p1OLED.printf("Get ready\nto start\nin...");
-            p1OLED.display();
-            p2OLED.display();
+            displayFrameBoth(FRAME_GETREADY);
         }
         else if((currentMillis - countdownStart) < 3000){
-            p1OLED.clearDisplay();
-            p1OLED.setCursor(40,0);
-            p1OLED.setTextSize(9);
-            p1OLED.printf("3");
-            p1OLED.display();
-            p2OLED.display();
+            displayFrameBoth(FRAME_COUNT3);
         }
         else if((currentMillis - countdownStart) < 4000){
-            p1OLED.clearDisplay();
-            p1OLED.setCursor(40,0);
-            p1OLED.printf("2");
-            p1OLED.display();
-            p2OLED.display();
+            displayFrameBoth(FRAME_COUNT2);
         }
         else{
-            p1OLED.clearDisplay();
-            p1OLED.setCursor(40,0);
-            p1OLED.printf("1");
-            p1OLED.display();
-            p2OLED.display();
+            displayFrameBoth(FRAME_COUNT1);
         }
     }
     else {
@@ -431,12 +489,16 @@ void countDown(){
         // lightUpBulbs(false, HueGreen, 150);
         turnOnOffWemoSwitches(true);
         // wemoWrite(MYWEMO[0], HIGH);
+        warmUpNetwork();                    //ready for the end of the round
         p1OLED.setTextSize(2);
         p1OLED.clearDisplay();
         p1OLED.display();
         p2OLED.setTextSize(2);
         p2OLED.clearDisplay();
         p2OLED.display();
+
+        inputEvents.clear();                //only edges after the start count
+        roundStartMicros = micros();
         gameMode = PLAYING;
     }
 
@@ -456,9 +518,22 @@ void showScore(){
     p1OLED.clearDisplay();
     p1OLED.setCursor(0,0);
     p1OLED.printf("Gold: %i\nBlue: %i", p1Score, p2Score);
-    p1OLED.display();
-    p2OLED.display();
-    delay(2000);
+    displayBoth();
+
+    scoreTimer = currentMillis;
+    gameMode = SHOWINGSCORE;
+}
+
+//  Leave the score up for 2 seconds, then turn off the bulbs
+//  and go back to waiting for the next round.
+void holdScore(){
+    if((currentMillis - scoreTimer) < 2000){
+        return;
+    }
+
+    lightUpBulbs(false, HueGreen, 150);
+    // setHue(BULBS[0], false, HueGreen, 150, 255);        //turn bulb off
+    gameMode = WAITING;
 }
 
 
@@ -477,31 +552,30 @@ void gameStartup(){
     p2OLED.setTextSize(2);
     p2OLED.display();
 
-    p1OLED.setCursor(0, 10);
-    p1OLED.printf("Slow\nMotion\nShowdown");
-    p1OLED.display();
-    p2OLED.display();       //This just displays the same as p1OLED. Using this to my advantage.
-    delay(3000);
-    
-    p1OLED.clearDisplay();
-    p1OLED.setCursor(10, 5);
-    p1OLED.setTextSize(3);
-    p1OLED.printf("Player");
-    p1OLED.setCursor(10, 35);
-    p1OLED.printf("1-Gold");
-    p1OLED.display();
-    p1OLED.setTextSize(2);
+    displayFrameBoth(FRAME_TITLE);
 
-    p2OLED.clearDisplay();
-    p2OLED.setCursor(10, 5);
-    p2OLED.setTextSize(3);
-    p2OLED.printf("Player");
-    p2OLED.setCursor(10, 35);
-    p2OLED.printf("2-Blue");
-    p2OLED.display();
-    p2OLED.setTextSize(2);
+    startupTimer = currentMillis;
+    gameMode = SHOWINGTITLE;
+}
 
-    delay(3000);
+//  After 3 seconds of the title, tell each player which color they are.
+void startupTitle(){
+    if((currentMillis - startupTimer) < 3000){
+        return;
+    }
+
+    p1OLED.displayFrame(FRAME_PLAYER1);
+    p2OLED.displayFrame(FRAME_PLAYER2);
+
+    startupTimer = currentMillis;
+    gameMode = SHOWINGPLAYERS;
+}
+
+//  After 3 more seconds, clear the screens and start waiting for players.
+void startupPlayers(){
+    if((currentMillis - startupTimer) < 3000){
+        return;
+    }
 
     p1OLED.clearDisplay();
     p1OLED.display();
@@ -517,10 +591,17 @@ void gameStartup(){
 
 //  Turn on or off up all of the Bulbs in the array.
 //  Makes it easy to switch between 1 or many bulbs.
+//  Returns right away; the Hue worker thread sends the commands.
+//  With the bulbs set up as a group, it's one request for all of them.
 void lightUpBulbs(bool _onOff, int _color, int _brightness){
     if (USEHUEBULBS){
-        for(int i=0; i< numBulbsToUse; i++){
-            setHue(BULBS[i], _onOff, _color, _brightness, 255);
+        if (hueGroup != 0){
+            hueQueue.setHueGroup(hueGroup, _onOff, _color, _brightness, 255);
+        }
+        else{
+            for(int i=0; i< numBulbsToUse; i++){
+                hueQueue.setHue(BULBS[i], _onOff, _color, _brightness, 255);
+            }
         }
     }
 }
@@ -532,20 +613,67 @@ void lightLEDStrip(int _color, bool _onOff, int _count){
         for(int i=0; i<PIXELCOUNT; i++){
             pixel.setPixelColor(i, _color);
         }
-        pixel.show();
     }
     else{
         for(int i=0; i<PIXELCOUNT; i++){
             pixel.clear();
         }
-        pixel.show();
     }
 }
 
 //Turns on or off all of the wemo switches in the array.
+//All outlets are switched at once; waits at most WEMOFANOUT_DEADLINE.
+//Without wifi only the speaker switch changes.
 void turnOnOffWemoSwitches(bool _onOff){
-    for(int i=0; i < numOutletsToUse; i++){
-        wemoWrite(MYWEMO[i], _onOff);
+    if (isWifiOn){
+        wemoFanout.write(MYWEMO, numOutletsToUse, _onOff);
     }
     digitalWrite(SPEAKERSWITCHPIN, _onOff);
-}
\ No newline at end of file
+}
+
+//  Opens the Hue and Wemo connections ahead of time, in the background,
+//  so the commands at the start and end of the round go out on warm
+//  sockets and the room reacts within a round trip.
+void warmUpNetwork(){
+    if (isWifiOn){
+        wemoFanout.warm(MYWEMO, numOutletsToUse);
+        if (USEHUEBULBS){
+            hueQueue.warm();
+        }
+    }
+}
+
+//  Drains the captured input events and returns the earliest one that
+//  can end a round (a player button or motion sensor).
+//  Ready button edges are not decisive and are dropped.
+bool firstRoundEvent(InputEvent &_decisive){
+    InputEvent event;
+    bool found = false;
+
+    while(inputEvents.pop(event)){
+        if(event.source == READYP1INPUT || event.source == READYP2INPUT){
+            continue;
+        }
+        if(!found || (int32_t)(event.timestamp - _decisive.timestamp) < 0){
+            _decisive = event;
+            found = true;
+        }
+    }
+    return found;
+}
+
+//  Show what was drawn on p1OLED on both screens.
+//  Each screen has its own buffer, so shared screens are drawn once
+//  and copied; display() only sends what changed on each panel.
+void displayBoth(){
+    memcpy(p2OLED.getBuffer(), p1OLED.getBuffer(), SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8);
+    p1OLED.display();
+    p2OLED.display();
+}
+
+//  Shows one of the prerendered screens in GameFrames.h on both panels.
+//  Nothing is drawn; only bytes that differ from the panels go out.
+void displayFrameBoth(const uint8_t *frame){
+    p1OLED.displayFrame(frame);
+    p2OLED.displayFrame(frame);
+}